@@ -0,0 +1,133 @@
+# Two stage build with profile guided optimization and LTO (GCC and Clang only).
+#
+# With CMLE_ENABLE_PGO the top level project only drives the stages in ${CMAKE_BINARY_DIR}/pgo:
+#
+#   1. configure with CMLE_PGO_STAGE=GENERATE and build the instrumented libraries and the training workload
+#   2. run the training workload, which writes the profile to ${CMAKE_BINARY_DIR}/pgo/profile
+#   3. reconfigure the same build directory with CMLE_PGO_STAGE=USE and rebuild with the profile and LTO
+#
+# Both stages use the same build directory, GCC looks up profiles by object file path.
+
+function(add_pgo_superbuild)
+    if(NOT CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+        message(FATAL_ERROR "CMLE_ENABLE_PGO is only supported with GCC and Clang")
+    endif()
+
+    include(ExternalProject)
+
+    set(stage_dir ${CMAKE_BINARY_DIR}/pgo)
+    set(profile_dir ${stage_dir}/profile)
+
+    if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        get_filename_component(compiler_dir ${CMAKE_CXX_COMPILER} DIRECTORY)
+        find_program(LLVM_PROFDATA llvm-profdata HINTS ${compiler_dir})
+        if(NOT LLVM_PROFDATA)
+            message(FATAL_ERROR "llvm-profdata is required to merge the training profile")
+        endif()
+        set(merge_profile COMMAND ${LLVM_PROFDATA} merge -output=${profile_dir}/cmle.profdata ${profile_dir})
+    endif()
+
+    set(build_type ${CMAKE_BUILD_TYPE})
+    if(build_type STREQUAL "Debug")
+        set(build_type "Release")
+    endif()
+
+    # lists would be split into separate arguments otherwise
+    string(REPLACE ";" "|" prefix_path "${CMAKE_PREFIX_PATH}")
+
+    set(stage_args
+        -G ${CMAKE_GENERATOR}
+        -DCMAKE_BUILD_TYPE=${build_type}
+        -DCMAKE_C_COMPILER=${CMAKE_C_COMPILER}
+        -DCMAKE_CXX_COMPILER=${CMAKE_CXX_COMPILER}
+        -DCMAKE_PREFIX_PATH=${prefix_path}
+        -DCMLE_ENABLE_CLI=${CMLE_ENABLE_CLI}
+        -DCMLE_ENABLE_IO_URING=${CMLE_ENABLE_IO_URING}
+        -DCMLE_ENABLE_UNITTESTS=OFF
+        -DCMLE_PGO_PROFILE_DIR=${profile_dir}
+        ${CMAKE_SOURCE_DIR}
+    )
+
+    ExternalProject_Add(cmle_pgo
+        SOURCE_DIR ${CMAKE_SOURCE_DIR}
+        BINARY_DIR ${stage_dir}
+        LIST_SEPARATOR |
+        CONFIGURE_COMMAND ${CMAKE_COMMAND} -DCMLE_PGO_STAGE=GENERATE ${stage_args}
+        BUILD_COMMAND ${CMAKE_COMMAND} --build . --target pgo_training
+        INSTALL_COMMAND ""
+        USES_TERMINAL_CONFIGURE TRUE
+        USES_TERMINAL_BUILD TRUE
+    )
+
+    ExternalProject_Add_Step(cmle_pgo train
+        COMMAND ${CMAKE_COMMAND} -E remove_directory ${profile_dir}
+        COMMAND ${stage_dir}/src/training/pgo_training${CMAKE_EXECUTABLE_SUFFIX}
+        ${merge_profile}
+        COMMENT "Running the PGO training workload"
+        DEPENDEES build
+        WORKING_DIRECTORY ${stage_dir}
+        USES_TERMINAL TRUE
+    )
+
+    ExternalProject_Add_Step(cmle_pgo optimize
+        COMMAND ${CMAKE_COMMAND} -DCMLE_PGO_STAGE=USE ${stage_args}
+        COMMAND ${CMAKE_COMMAND} --build .
+        COMMENT "Building with the PGO profile and LTO"
+        DEPENDEES train
+        DEPENDERS install
+        WORKING_DIRECTORY ${stage_dir}
+        USES_TERMINAL TRUE
+    )
+
+    message(STATUS "PGO build, the optimized binaries are written to ${stage_dir}")
+endfunction()
+
+function(set_pgo_options)
+    if(CMLE_PGO_STAGE STREQUAL "GENERATE")
+        set(compile_options -fprofile-generate=${CMLE_PGO_PROFILE_DIR})
+        if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+            list(APPEND compile_options -fprofile-update=atomic)
+        endif()
+
+        foreach(target ${ARGN})
+            target_compile_options(${target} PRIVATE ${compile_options})
+            # the libraries are static, the executables linking them need the profiling runtime
+            target_link_options(${target} INTERFACE -fprofile-generate=${CMLE_PGO_PROFILE_DIR})
+        endforeach()
+    elseif(CMLE_PGO_STAGE STREQUAL "USE")
+        if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+            set(compile_options
+                -fprofile-use=${CMLE_PGO_PROFILE_DIR}/cmle.profdata
+                -Wno-profile-instr-unprofiled
+                -Wno-profile-instr-out-of-date
+            )
+        else()
+            set(compile_options
+                -fprofile-use=${CMLE_PGO_PROFILE_DIR}
+                -Wno-missing-profile
+            )
+            # keeps code the training does not reach optimized for speed
+            if(CMAKE_CXX_COMPILER_VERSION VERSION_GREATER_EQUAL 10)
+                list(APPEND compile_options -fprofile-partial-training)
+            endif()
+        endif()
+
+        foreach(target ${ARGN})
+            target_compile_options(${target} PRIVATE ${compile_options})
+        endforeach()
+    endif()
+endfunction()
+
+function(enable_pgo_lto)
+    if(NOT CMLE_PGO_STAGE STREQUAL "USE")
+        return()
+    endif()
+
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT ipo_supported OUTPUT ipo_output LANGUAGES C CXX)
+    if(ipo_supported)
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON PARENT_SCOPE)
+    else()
+        message(WARNING "LTO is not supported: ${ipo_output}")
+    endif()
+endfunction()
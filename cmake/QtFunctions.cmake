@@ -18,6 +18,10 @@ macro(qt_load_packages)
     find_package(Qt6 REQUIRED COMPONENTS Core)
 endmacro()
 
+macro(qt_load_cli_packages)
+    find_package(Qt6 REQUIRED COMPONENTS Network)
+endmacro()
+
 macro(qt_load_test_packages)
     find_package(Qt6 REQUIRED COMPONENTS Test)
 endmacro()
@@ -0,0 +1,246 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "include/cmle/cmle.h"
+
+#include <cmle/core/FileIo.h>
+#include <cmle/core/ListFile.h>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <string>
+
+struct cmle_file
+{
+    cmle::core::ListFile listFile;
+    std::string path;
+    // rendered content, kept until the next edit
+    std::optional<std::string> output;
+    // reused by all queries
+    std::string scratch;
+};
+
+namespace {
+
+// exceptions must not cross the C boundary
+template<typename Function>
+cmle_status guarded(Function function) noexcept
+{
+    try
+    {
+        return function();
+    }
+    catch (const std::bad_alloc&)
+    {
+        return CMLE_ERROR_OUT_OF_MEMORY;
+    }
+    catch (...)
+    {
+        return CMLE_ERROR_IO;
+    }
+}
+
+cmle_status copyTo(const std::string& content, char* buffer, size_t capacity, size_t* length)
+{
+    *length = content.size();
+    if (!buffer || capacity < content.size())
+        return CMLE_ERROR_BUFFER_TOO_SMALL;
+    std::memcpy(buffer, content.data(), content.size());
+    return CMLE_OK;
+}
+
+const std::string& render(cmle_file* file)
+{
+    if (!file->output)
+    {
+        file->output.emplace();
+        file->listFile.write(*file->output);
+    }
+    return *file->output;
+}
+
+cmle_status edited(cmle_file* file, bool success)
+{
+    if (!success)
+        return CMLE_ERROR_NOT_FOUND;
+    file->output.reset();
+    return CMLE_OK;
+}
+
+void appendEntries(std::string& output, const std::vector<std::string>& entries)
+{
+    for (const auto& entry : entries)
+    {
+        output += entry;
+        output += '\0';
+    }
+}
+
+cmle_status open(std::string content, std::string path, cmle_file** file)
+{
+    auto output = new cmle_file{cmle::core::ListFile{std::move(content)}, std::move(path), {}, {}};
+    if (!output->listFile.isLoaded())
+    {
+        delete output;
+        return CMLE_ERROR_PARSE;
+    }
+    *file = output;
+    return CMLE_OK;
+}
+
+} // namespace
+
+int cmle_api_version(void)
+{
+    return CMLE_API_VERSION;
+}
+
+const char* cmle_status_string(cmle_status status)
+{
+    switch (status)
+    {
+        case CMLE_OK: return "ok";
+        case CMLE_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case CMLE_ERROR_IO: return "could not read or write file";
+        case CMLE_ERROR_PARSE: return "could not parse CMakeLists file";
+        case CMLE_ERROR_NOT_FOUND: return "target or file name not found";
+        case CMLE_ERROR_BUFFER_TOO_SMALL: return "buffer too small";
+        case CMLE_ERROR_OUT_OF_MEMORY: return "out of memory";
+    }
+    return "unknown status";
+}
+
+cmle_status cmle_open(const char* path, cmle_file** file)
+{
+    if (!file)
+        return CMLE_ERROR_INVALID_ARGUMENT;
+    *file = nullptr;
+    if (!path)
+        return CMLE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]() {
+        std::string content;
+        if (!cmle::core::readFile(path, content))
+            return CMLE_ERROR_IO;
+
+        return open(std::move(content), path, file);
+    });
+}
+
+cmle_status cmle_open_buffer(const char* data, size_t size, cmle_file** file)
+{
+    if (!file)
+        return CMLE_ERROR_INVALID_ARGUMENT;
+    *file = nullptr;
+    if (!data && size > 0)
+        return CMLE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]() { return open(std::string(data, size), {}, file); });
+}
+
+void cmle_close(cmle_file* file)
+{
+    delete file;
+}
+
+cmle_status cmle_set_sort(cmle_file* file, int sort)
+{
+    if (!file)
+        return CMLE_ERROR_INVALID_ARGUMENT;
+
+    file->listFile.setSortSectionPolicy(sort ? cmle::core::SortSectionPolicy::Sort
+                                             : cmle::core::SortSectionPolicy::NoSort);
+    return CMLE_OK;
+}
+
+int cmle_has_changes(const cmle_file* file)
+{
+    return file && file->listFile.hasChangedBlocks() ? 1 : 0;
+}
+
+cmle_status cmle_add(cmle_file* file, const char* target, const char* file_name)
+{
+    if (!file || !target || !file_name)
+        return CMLE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]() { return edited(file, file->listFile.addSourceFile(target, file_name)); });
+}
+
+cmle_status cmle_remove(cmle_file* file, const char* target, const char* file_name)
+{
+    if (!file || !target || !file_name)
+        return CMLE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]() { return edited(file, file->listFile.removeSourceFile(target, file_name)); });
+}
+
+cmle_status cmle_rename(cmle_file* file, const char* target, const char* old_file_name, const char* new_file_name)
+{
+    if (!file || !target || !old_file_name || !new_file_name)
+        return CMLE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]() {
+        return edited(file, file->listFile.renameSourceFile(target, old_file_name, new_file_name));
+    });
+}
+
+cmle_status cmle_write_to(cmle_file* file, char* buffer, size_t capacity, size_t* length)
+{
+    if (!file || !length)
+        return CMLE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]() { return copyTo(render(file), buffer, capacity, length); });
+}
+
+cmle_status cmle_save(cmle_file* file, const char* path)
+{
+    if (!file || (!path && file->path.empty()))
+        return CMLE_ERROR_INVALID_ARGUMENT;
+
+    if (!path && !file->listFile.hasChangedBlocks())
+        return CMLE_OK;
+
+    return guarded([&]() {
+        std::string target = path ? path : file->path;
+        if (!cmle::core::writeFileAtomically(target, render(file)))
+            return CMLE_ERROR_IO;
+
+        // The saved content becomes the unchanged state of the edited model, without parsing it again. The rendered
+        // output moves into the model and is only rendered again if it is requested.
+        file->listFile.markSaved(std::move(*file->output));
+        file->output.reset();
+        file->path = std::move(target);
+        return CMLE_OK;
+    });
+}
+
+cmle_status cmle_query(cmle_file* file, cmle_query_kind kind, const char* target, char* buffer, size_t capacity,
+                       size_t* length)
+{
+    if (!file || !length || (kind == CMLE_QUERY_SOURCES && !target))
+        return CMLE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]() {
+        auto& output = file->scratch;
+        output.clear();
+
+        switch (kind)
+        {
+            case CMLE_QUERY_TARGETS:
+                appendEntries(output, file->listFile.targets());
+                break;
+            case CMLE_QUERY_SOURCES:
+                if (!file->listFile.hasTarget(target))
+                    return CMLE_ERROR_NOT_FOUND;
+                appendEntries(output, file->listFile.sourceFiles(target));
+                break;
+            case CMLE_QUERY_SUBDIRECTORIES:
+                appendEntries(output, file->listFile.subdirectories());
+                break;
+            default:
+                return CMLE_ERROR_INVALID_ARGUMENT;
+        }
+
+        return copyTo(output, buffer, capacity, length);
+    });
+}
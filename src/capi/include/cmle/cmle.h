@@ -0,0 +1,91 @@
+/* Copyright 2023, Daniel Volk <mail@volkarts.com>
+ * SPDX-License-Identifier: GPL-3.0-only */
+
+/* C API of CMakeListsEdit for tooling in other languages (e.g. via ctypes or Rust FFI).
+ *
+ * All strings are UTF-8 and NUL terminated. Functions returning content take a caller provided buffer: if it is too
+ * small (or NULL) CMLE_ERROR_BUFFER_TOO_SMALL is returned and *length is set to the required size, so the call can be
+ * repeated with a larger buffer. The content is rendered once and kept until the next edit, repeating a call does not
+ * render it again. A cmle_file must not be used from several threads at once. */
+
+#ifndef CMLE_CMLE_H
+#define CMLE_CMLE_H
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  if defined(CMLE_CAPI_BUILD)
+#    define CMLE_API __declspec(dllexport)
+#  else
+#    define CMLE_API __declspec(dllimport)
+#  endif
+#else
+#  define CMLE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CMLE_API_VERSION 1
+
+typedef struct cmle_file cmle_file;
+
+typedef enum cmle_status
+{
+    CMLE_OK = 0,
+    CMLE_ERROR_INVALID_ARGUMENT = 1,
+    CMLE_ERROR_IO = 2,
+    CMLE_ERROR_PARSE = 3,
+    /* the target or file name does not exist */
+    CMLE_ERROR_NOT_FOUND = 4,
+    CMLE_ERROR_BUFFER_TOO_SMALL = 5,
+    CMLE_ERROR_OUT_OF_MEMORY = 6
+} cmle_status;
+
+typedef enum cmle_query_kind
+{
+    /* all targets, sorted by name */
+    CMLE_QUERY_TARGETS = 0,
+    /* the source files of a target */
+    CMLE_QUERY_SOURCES = 1,
+    /* the directories of add_subdirectory() calls */
+    CMLE_QUERY_SUBDIRECTORIES = 2
+} cmle_query_kind;
+
+CMLE_API int cmle_api_version(void);
+CMLE_API const char* cmle_status_string(cmle_status status);
+
+/* Reads and parses the CMakeLists file at path. *file is NULL on errors. */
+CMLE_API cmle_status cmle_open(const char* path, cmle_file** file);
+/* Parses size bytes of data, which are copied. */
+CMLE_API cmle_status cmle_open_buffer(const char* data, size_t size, cmle_file** file);
+CMLE_API void cmle_close(cmle_file* file);
+
+/* Keep sections sorted after edits if sort is not 0. */
+CMLE_API cmle_status cmle_set_sort(cmle_file* file, int sort);
+/* Returns 1 if the file was edited, 0 otherwise. */
+CMLE_API int cmle_has_changes(const cmle_file* file);
+
+CMLE_API cmle_status cmle_add(cmle_file* file, const char* target, const char* file_name);
+CMLE_API cmle_status cmle_remove(cmle_file* file, const char* target, const char* file_name);
+CMLE_API cmle_status cmle_rename(cmle_file* file, const char* target, const char* old_file_name,
+                                 const char* new_file_name);
+
+/* Writes the current content to buffer, *length is set to its size in bytes. The content is not NUL terminated. */
+CMLE_API cmle_status cmle_write_to(cmle_file* file, char* buffer, size_t capacity, size_t* length);
+/* Writes the current content to path, or to the opened file if path is NULL. The content is written to a temporary
+ * file which replaces the target, so the target is never left half written. The opened file is not touched if it was
+ * not edited. After a successful save the file has no changes and path becomes the opened file. */
+CMLE_API cmle_status cmle_save(cmle_file* file, const char* path);
+
+/* Writes the result of a query to buffer as a sequence of NUL terminated strings, *length is the size of all of them
+ * in bytes. target is only used by CMLE_QUERY_SOURCES, which fails with CMLE_ERROR_NOT_FOUND for an unknown target. */
+CMLE_API cmle_status cmle_query(cmle_file* file, cmle_query_kind kind, const char* target, char* buffer,
+                                size_t capacity, size_t* length);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* CMLE_CMLE_H */
@@ -0,0 +1,198 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Batch.h"
+
+#include <cmle/AsyncFileLoader.h>
+#include <cmle/CMakeListsFile.h>
+#include <cmle/StandardFileBuffer.h>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QProcess>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+
+namespace cmle::cli {
+
+namespace {
+
+bool parseJsonOperation(const QByteArray& line, Operation& operation, QString& errorMessage)
+{
+    QJsonParseError parseError{};
+    const auto document = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError)
+    {
+        errorMessage = parseError.errorString();
+        return false;
+    }
+    if (!document.isObject())
+    {
+        errorMessage = QStringLiteral("Operation is not a JSON object");
+        return false;
+    }
+
+    return operationFromJson(document.object(), operation, errorMessage);
+}
+
+bool parseScriptOperation(const QByteArray& line, Operation& operation, QString& errorMessage)
+{
+    const auto arguments = QProcess::splitCommand(QString::fromUtf8(line));
+    if (arguments.size() < 3)
+    {
+        errorMessage = QStringLiteral("Expected <command> <CMakeLists.txt> <target> <file-names>...");
+        return false;
+    }
+
+    operation.command = arguments[0];
+    operation.cmlFile = arguments[1];
+    operation.target = arguments[2];
+    operation.fileNames = arguments.mid(3);
+
+    return true;
+}
+
+// Returns false if the script cannot be read at all. Invalid lines are reported, skipped and counted in invalidLines.
+bool readScript(const QString& scriptFile, bool sort, QList<Operation>& operations, int& invalidLines)
+{
+    QFile file;
+    bool opened{};
+    if (scriptFile == QLatin1String("-"))
+    {
+        opened = file.open(stdin, QFile::ReadOnly);
+    }
+    else
+    {
+        file.setFileName(scriptFile);
+        opened = file.open(QFile::ReadOnly);
+    }
+    if (!opened)
+    {
+        std::cerr << "Could not open script " << qPrintable(scriptFile) << std::endl;
+        return false;
+    }
+
+    int lineNumber = 0;
+    while (true)
+    {
+        // an empty result means EOF, every other line contains at least the line break
+        QByteArray line = file.readLine();
+        if (line.isEmpty())
+            break;
+
+        ++lineNumber;
+        line = line.trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        Operation operation;
+        operation.sort = sort;
+
+        QString errorMessage;
+        const bool parsed = line.startsWith('{') ? parseJsonOperation(line, operation, errorMessage) :
+                                                   parseScriptOperation(line, operation, errorMessage);
+        if (!parsed || !validateOperation(operation, errorMessage))
+        {
+            std::cerr << qPrintable(scriptFile) << ":" << lineNumber << ": " << qPrintable(errorMessage)
+                      << ", line skipped" << std::endl;
+            ++invalidLines;
+            continue;
+        }
+
+        operations << operation;
+    }
+
+    return true;
+}
+
+} // namespace
+
+int applyInPlace(const QList<Operation>& operations, int jobs)
+{
+    // group operations by CMakeLists file, keeping the order of the operations for each file
+    QStringList cmlFiles;
+    QHash<QString, QList<Operation>> fileOperations;
+    for (const auto& operation : qAsConst(operations))
+    {
+        const auto cmlFile = QFileInfo{operation.cmlFile}.absoluteFilePath();
+        auto pos = fileOperations.find(cmlFile);
+        if (pos == fileOperations.end())
+        {
+            cmlFiles << cmlFile;
+            pos = fileOperations.insert(cmlFile, {});
+        }
+        pos->append(operation);
+    }
+
+    QMutex outputMutex;
+    std::atomic<int> failedFiles{0};
+
+    auto reportError = [&outputMutex](const QString& fileName, const QString& errorMessage) {
+        QMutexLocker lock{&outputMutex};
+        std::cerr << qPrintable(fileName) << ": " << qPrintable(errorMessage) << std::endl;
+    };
+
+    AsyncFileLoader loader;
+    if (jobs > 0)
+        loader.setMaxThreadCount(jobs);
+    loader.load(cmlFiles, [&](const QString& fileName, const QByteArray& content, bool loaded) {
+        if (!loaded)
+        {
+            reportError(fileName, QStringLiteral("Could not read CMakeLists file"));
+            ++failedFiles;
+            return;
+        }
+
+        CMakeListsFile cmakeListsFile{content};
+        if (!cmakeListsFile.isLoaded())
+        {
+            reportError(fileName, QStringLiteral("Could not parse CMakeLists file"));
+            ++failedFiles;
+            return;
+        }
+
+        bool success = true;
+        for (const auto& operation : fileOperations.value(fileName))
+        {
+            QString errorMessage;
+            if (!applyOperation(cmakeListsFile, operation, errorMessage))
+            {
+                reportError(fileName, errorMessage);
+                success = false;
+            }
+        }
+
+        if (cmakeListsFile.hasChangedBlocks())
+        {
+            StandardFileBuffer output{fileName};
+            output.setSavePolicy(SavePolicy::SkipUnchanged);
+            output.setContent(cmakeListsFile.write());
+            if (!output.save())
+            {
+                reportError(fileName, QStringLiteral("Could not write CMakeLists file"));
+                success = false;
+            }
+        }
+
+        if (!success)
+            ++failedFiles;
+    });
+
+    return failedFiles > 0 ? 1 : 0;
+}
+
+int runBatch(const BatchOptions& options)
+{
+    QList<Operation> operations;
+    int invalidLines = 0;
+    if (!readScript(options.scriptFile, options.sort, operations, invalidLines))
+        return 1;
+
+    const int result = applyInPlace(operations, options.jobs);
+    return invalidLines > 0 ? 1 : result;
+}
+
+} // namespace cmle::cli
@@ -0,0 +1,33 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "Operation.h"
+#include <QList>
+
+namespace cmle::cli {
+
+struct BatchOptions
+{
+    QString scriptFile;
+    bool sort = false;
+    int jobs = 0;
+};
+
+// Applies the operations in place. Every CMakeLists file is read, parsed and written only once and files are processed
+// concurrently by up to jobs threads (0 uses one thread per CPU core). Files which end up with unchanged content are
+// not written. Errors are reported per file and do not stop the processing of the other files.
+int applyInPlace(const QList<Operation>& operations, int jobs);
+
+// Reads operations from a script (one operation per line, "-" for stdin) and applies them with applyInPlace().
+//
+// A line is either a JSON object
+//   {"command": "add", "file": "CMakeLists.txt", "target": "main", "fileNames": ["a.cpp", "b.cpp"], "sort": true}
+// or a shell like command
+//   add CMakeLists.txt main a.cpp b.cpp
+// Empty lines and lines starting with # are ignored. Invalid lines are reported and skipped, the remaining operations
+// are still applied, but the result is non-zero.
+int runBatch(const BatchOptions& options);
+
+} // namespace cmle::cli
@@ -3,19 +3,27 @@
 
 #include <iostream>
 
+#include "Batch.h"
+#include "Operation.h"
+#include "Query.h"
+#include "Server.h"
 #include <cmle/CMakeListsFile.h>
 #include <QCommandLineParser>
 #include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 namespace {
 
 struct Options
 {
-    QString command;
-    QString target;
-    QString cmlFile;
-    QStringList fileNames;
-    bool sort = false;
+    cmle::cli::Operation operation;
+    QStringList cmlFiles;
+    bool inPlace = false;
+    int jobs = 0;
+    QString batchFile;
+    QString serverName;
 };
 
 enum class CommandLineParseResult
@@ -34,16 +42,45 @@ CommandLineParseResult parseCommandLine(QCommandLineParser& parser, Options& opt
                 {QStringLiteral("del"), QStringLiteral("Delete a file name from cmake target (command).")},
                 {QStringLiteral("ren"), QStringLiteral("Rename a file name from cmake target (command).")},
 
+                {QStringLiteral("targets"), QStringLiteral("List all targets as JSON (command).")},
+                {QStringLiteral("sources"),
+                 QStringLiteral("List the file names of all targets or of the given target as JSON (command).")},
+                {QStringLiteral("owners"),
+                 QStringLiteral("List the targets containing the given file names as JSON (command).")},
+                {QStringLiteral("dump"), QStringLiteral("Dump all source defining functions as JSON (command).")},
+
                 {{QStringLiteral("t"), QStringLiteral("target")},
                  QStringLiteral("The cmake target name for the file operations (required)."),
                  QStringLiteral("target")},
 
                 {{QStringLiteral("f"), QStringLiteral("file")},
-                 QStringLiteral("Path to the CMakeLists.txt file (required)."),
+                 QStringLiteral("Path to the CMakeLists.txt file (required). Can be given multiple times together "
+                                "with --in-place."),
                  QStringLiteral("file")},
 
+                {{QStringLiteral("i"), QStringLiteral("in-place")},
+                 QStringLiteral("Write the result back to the CMakeLists.txt file(s) instead of stdout. Files with "
+                                "unchanged content are not touched.")},
+
+                {{QStringLiteral("j"), QStringLiteral("jobs")},
+                 QStringLiteral("Number of CMakeLists.txt files processed in parallel with --in-place or --batch "
+                                "(default: number of CPU cores)."),
+                 QStringLiteral("N")},
+
+                {QStringLiteral("section"),
+                 QStringLiteral("Restrict --sources to the section <section> (e.g. PRIVATE)."),
+                 QStringLiteral("section")},
+
                 {{QStringLiteral("s"), QStringLiteral("sort")},
                  QStringLiteral("Sort section after adding/removing/renaming file.")},
+
+                {{QStringLiteral("b"), QStringLiteral("batch")},
+                 QStringLiteral("Apply the operations read from <script> (\"-\" for stdin) in place (command)."),
+                 QStringLiteral("script")},
+
+                {QStringLiteral("serve"),
+                 QStringLiteral("Keep running and serve requests on the local socket <name> (command)."),
+                 QStringLiteral("name")},
                 });
 
     parser.addPositionalArgument(QStringLiteral("file-names"), QStringLiteral("File names to add/remove/rename"),
@@ -56,69 +93,84 @@ CommandLineParseResult parseCommandLine(QCommandLineParser& parser, Options& opt
         return CommandLineParseResult::Error;
     }
 
-    for (const auto& cmd : QStringList{QStringLiteral("add"), QStringLiteral("del"), QStringLiteral("ren")})
+    options.operation.sort = parser.isSet(QStringLiteral("sort"));
+    options.inPlace = parser.isSet(QStringLiteral("in-place"));
+
+    if (parser.isSet(QStringLiteral("jobs")))
+    {
+        bool ok{};
+        options.jobs = parser.value(QStringLiteral("jobs")).toInt(&ok);
+        if (!ok || options.jobs < 1)
+        {
+            errorMessage = QStringLiteral("Invalid number of jobs");
+            return CommandLineParseResult::Error;
+        }
+    }
+
+    for (const auto& cmd : QStringList{QStringLiteral("add"), QStringLiteral("del"), QStringLiteral("ren"),
+                                       QStringLiteral("targets"), QStringLiteral("sources"), QStringLiteral("owners"),
+                                       QStringLiteral("dump")})
     {
         if (parser.isSet(cmd))
         {
-            if (!options.command.isEmpty())
+            if (!options.operation.command.isEmpty())
             {
                 errorMessage = QStringLiteral("Only one command can be specified");
                 return CommandLineParseResult::Error;
             }
 
-            options.command = cmd;
+            options.operation.command = cmd;
         }
     }
 
-    if (options.command.isEmpty())
+    // --batch and --serve read their operations from elsewhere, anything given on the command line would be ignored
+    const bool serve = parser.isSet(QStringLiteral("serve"));
+    const bool batch = parser.isSet(QStringLiteral("batch"));
+    if (serve || batch)
     {
-        errorMessage = QStringLiteral("No command specified");
-        return CommandLineParseResult::Error;
-    }
-
-    options.target = parser.value(QStringLiteral("target"));
-    if (options.target.isEmpty())
-    {
-        errorMessage = QStringLiteral("No target specified");
-        return CommandLineParseResult::Error;
-    }
-
-    options.cmlFile = parser.value(QStringLiteral("file"));
-    if (options.cmlFile.isEmpty())
-    {
-        errorMessage = QStringLiteral("No CMakeLists.txt file specified");
-        return CommandLineParseResult::Error;
-    }
-
-    const QStringList positionalArguments = parser.positionalArguments();
-
-    if (options.command == QLatin1String("add") || options.command == QLatin1String("del"))
-    {
-        if (positionalArguments.size() < 1)
+        if (serve && batch)
         {
-            errorMessage = QStringLiteral("No file names specified");
+            errorMessage = QStringLiteral("--batch and --serve cannot be combined");
             return CommandLineParseResult::Error;
         }
 
-        options.fileNames = positionalArguments;
-    }
-    else if (options.command == QLatin1String("ren"))
-    {
-        if (positionalArguments.size() != 2)
+        if (!options.operation.command.isEmpty() || parser.isSet(QStringLiteral("target")) ||
+                parser.isSet(QStringLiteral("file")) || parser.isSet(QStringLiteral("section")) ||
+                options.inPlace || !parser.positionalArguments().isEmpty())
         {
-            errorMessage = QStringLiteral("Specify a source and a target file name");
+            errorMessage = QStringLiteral("--%1 cannot be combined with a command, target, file, file names or "
+                                          "--in-place")
+                    .arg(serve ? QLatin1String("serve") : QLatin1String("batch"));
             return CommandLineParseResult::Error;
         }
 
-        options.fileNames = positionalArguments;
+        if (serve)
+            options.serverName = parser.value(QStringLiteral("serve"));
+        else
+            options.batchFile = parser.value(QStringLiteral("batch"));
+        return CommandLineParseResult::Ok;
     }
-    else
+
+    options.operation.target = parser.value(QStringLiteral("target"));
+    options.cmlFiles = parser.values(QStringLiteral("file"));
+    options.operation.cmlFile = options.cmlFiles.value(0);
+    options.operation.fileNames = parser.positionalArguments();
+    options.operation.section = parser.value(QStringLiteral("section"));
+
+    if (!cmle::cli::validateOperation(options.operation, errorMessage))
+        return CommandLineParseResult::Error;
+
+    if (cmle::cli::isQueryCommand(options.operation.command) && (options.inPlace || options.cmlFiles.size() > 1))
     {
-        errorMessage = QStringLiteral("Invalid command");
+        errorMessage = QStringLiteral("Queries work on a single CMakeLists.txt file only");
         return CommandLineParseResult::Error;
     }
 
-    options.sort = parser.isSet(QStringLiteral("sort"));
+    if (options.cmlFiles.size() > 1 && !options.inPlace)
+    {
+        errorMessage = QStringLiteral("Multiple CMakeLists.txt files require --in-place");
+        return CommandLineParseResult::Error;
+    }
 
     return CommandLineParseResult::Ok;
 }
@@ -151,7 +203,29 @@ int main(int argc, char* argv[])
             Q_UNREACHABLE();
     }
 
-    QFile fileBuffer{options.cmlFile};
+    if (!options.serverName.isEmpty())
+    {
+        cmle::cli::Server server;
+        if (!server.listen(options.serverName))
+            return 1;
+        return app.exec();
+    }
+
+    if (!options.batchFile.isEmpty())
+        return cmle::cli::runBatch({options.batchFile, options.operation.sort, options.jobs});
+
+    if (options.inPlace)
+    {
+        QList<cmle::cli::Operation> operations;
+        for (const auto& cmlFile : qAsConst(options.cmlFiles))
+        {
+            operations << options.operation;
+            operations.last().cmlFile = cmlFile;
+        }
+        return cmle::cli::applyInPlace(operations, options.jobs);
+    }
+
+    QFile fileBuffer{options.operation.cmlFile};
     if (!fileBuffer.open(QFile::ReadOnly))
     {
         std::cerr << "CMakeLists file does not exists" << std::endl;
@@ -165,26 +239,21 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    cmakeListsFile.setSortSectionPolicy(options.sort ? cmle::SortSectionPolicy::Sort :
-                                                       cmle::SortSectionPolicy::NoSort);
-
-    if (options.command == QLatin1String("add"))
+    if (cmle::cli::isQueryCommand(options.operation.command))
     {
-        for (const auto& f : qAsConst(options.fileNames))
-        {
-            cmakeListsFile.addSourceFile(options.target, f);
-        }
+        const auto result = cmle::cli::runQuery(cmakeListsFile, options.operation);
+        const auto json = result.isArray() ? QJsonDocument{result.toArray()}.toJson(QJsonDocument::Compact) :
+                                             QJsonDocument{result.toObject()}.toJson(QJsonDocument::Compact);
+        std::cout.write(json.constData(), json.size());
+        std::cout << std::endl;
+        return 0;
     }
-    else if (options.command == QLatin1String("ren"))
-    {
-        cmakeListsFile.renameSourceFile(options.target, options.fileNames[0], options.fileNames[1]);
-    }
-    if (options.command == QLatin1String("del"))
+
+    QString operationError;
+    if (!cmle::cli::applyOperation(cmakeListsFile, options.operation, operationError))
     {
-        for (const auto& f : qAsConst(options.fileNames))
-        {
-            cmakeListsFile.removeSourceFile(options.target, f);
-        }
+        std::cerr << qPrintable(operationError) << std::endl;
+        return 1;
     }
 
     const auto output = cmakeListsFile.write();
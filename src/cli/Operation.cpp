@@ -0,0 +1,133 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Operation.h"
+
+#include <cmle/CMakeListsFile.h>
+#include <QJsonArray>
+
+namespace cmle::cli {
+
+bool isQueryCommand(const QString& command)
+{
+    return command == QLatin1String("targets") || command == QLatin1String("sources") ||
+            command == QLatin1String("owners") || command == QLatin1String("dump");
+}
+
+bool operationFromJson(const QJsonObject& object, Operation& operation, QString& errorMessage)
+{
+    const auto fileNames = object.value(QLatin1String("fileNames"));
+    if (!fileNames.isUndefined() && !fileNames.isArray())
+    {
+        errorMessage = QStringLiteral("fileNames must be an array");
+        return false;
+    }
+
+    operation.command = object.value(QLatin1String("command")).toString(operation.command);
+    operation.cmlFile = object.value(QLatin1String("file")).toString(operation.cmlFile);
+    operation.target = object.value(QLatin1String("target")).toString(operation.target);
+    operation.section = object.value(QLatin1String("section")).toString(operation.section);
+    operation.sort = object.value(QLatin1String("sort")).toBool(operation.sort);
+
+    const auto fileNamesArray = fileNames.toArray();
+    for (const auto& fileName : fileNamesArray)
+    {
+        operation.fileNames << fileName.toString();
+    }
+
+    return true;
+}
+
+bool validateOperation(const Operation& operation, QString& errorMessage)
+{
+    if (operation.command.isEmpty())
+    {
+        errorMessage = QStringLiteral("No command specified");
+        return false;
+    }
+
+    // queries work on all targets if none is given
+    if (operation.target.isEmpty() && !isQueryCommand(operation.command))
+    {
+        errorMessage = QStringLiteral("No target specified");
+        return false;
+    }
+
+    if (operation.cmlFile.isEmpty())
+    {
+        errorMessage = QStringLiteral("No CMakeLists.txt file specified");
+        return false;
+    }
+
+    if (operation.command == QLatin1String("add") || operation.command == QLatin1String("del"))
+    {
+        if (operation.fileNames.size() < 1)
+        {
+            errorMessage = QStringLiteral("No file names specified");
+            return false;
+        }
+    }
+    else if (operation.command == QLatin1String("ren"))
+    {
+        if (operation.fileNames.size() != 2)
+        {
+            errorMessage = QStringLiteral("Specify a source and a target file name");
+            return false;
+        }
+    }
+    else if (operation.command == QLatin1String("owners"))
+    {
+        if (operation.fileNames.size() < 1)
+        {
+            errorMessage = QStringLiteral("No file names specified");
+            return false;
+        }
+    }
+    else if (!isQueryCommand(operation.command))
+    {
+        errorMessage = QStringLiteral("Invalid command");
+        return false;
+    }
+
+    return true;
+}
+
+bool applyOperation(CMakeListsFile& cmakeListsFile, const Operation& operation, QString& errorMessage)
+{
+    cmakeListsFile.setSortSectionPolicy(operation.sort ? SortSectionPolicy::Sort : SortSectionPolicy::NoSort);
+
+    QStringList failed;
+
+    if (operation.command == QLatin1String("add"))
+    {
+        for (const auto& f : operation.fileNames)
+        {
+            if (!cmakeListsFile.addSourceFile(operation.target, f))
+                failed << f;
+        }
+    }
+    else if (operation.command == QLatin1String("ren"))
+    {
+        if (!cmakeListsFile.renameSourceFile(operation.target, operation.fileNames[0], operation.fileNames[1]))
+            failed << operation.fileNames[0];
+    }
+    else if (operation.command == QLatin1String("del"))
+    {
+        for (const auto& f : operation.fileNames)
+        {
+            if (!cmakeListsFile.removeSourceFile(operation.target, f))
+                failed << f;
+        }
+    }
+
+    if (!failed.isEmpty())
+    {
+        errorMessage = QStringLiteral("Command %1 failed for target %2: %3")
+                .arg(operation.command, operation.target, failed.join(QLatin1String(", ")));
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace cmle::cli
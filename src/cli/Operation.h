@@ -0,0 +1,38 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QJsonObject>
+#include <QStringList>
+
+namespace cmle {
+
+class CMakeListsFile;
+
+namespace cli {
+
+struct Operation
+{
+    QString command;
+    QString target;
+    QString cmlFile;
+    QStringList fileNames;
+    QString section;
+    bool sort = false;
+};
+
+// Read-only commands, see runQuery()
+bool isQueryCommand(const QString& command);
+
+// Reads an operation from a JSON object with the keys "command", "file", "target", "fileNames", "section" and "sort".
+// Keys not present keep the value already set in the operation.
+bool operationFromJson(const QJsonObject& object, Operation& operation, QString& errorMessage);
+
+bool validateOperation(const Operation& operation, QString& errorMessage);
+
+bool applyOperation(CMakeListsFile& cmakeListsFile, const Operation& operation, QString& errorMessage);
+
+} // namespace cli
+
+} // namespace cmle
@@ -0,0 +1,95 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Query.h"
+
+#include <cmle/CMakeListsFile.h>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMap>
+
+namespace cmle::cli {
+
+QJsonValue runQuery(const CMakeListsFile& cmakeListsFile, const Operation& operation)
+{
+    if (operation.command == QLatin1String("targets"))
+    {
+        return QJsonArray::fromStringList(cmakeListsFile.targets());
+    }
+
+    if (operation.command == QLatin1String("sources"))
+    {
+        // collect in a single pass over the model, a target may have several blocks with the same sections
+        QMap<QString, QMap<QString, QStringList>> sources;
+        if (!operation.target.isEmpty())
+            sources.insert(operation.target, {});
+
+        const auto blocks = cmakeListsFile.sourcesBlocks();
+        for (const auto& block : blocks)
+        {
+            if (!operation.target.isEmpty() && block.target != operation.target)
+                continue;
+
+            auto& targetSections = sources[block.target];
+            for (const auto& section : block.sections)
+            {
+                if (!operation.section.isEmpty() && section.name.compare(operation.section, Qt::CaseInsensitive) != 0)
+                    continue;
+
+                targetSections[section.name] << section.fileNames;
+            }
+        }
+
+        QJsonObject output;
+        for (auto target = sources.cbegin(); target != sources.cend(); ++target)
+        {
+            QJsonObject sections;
+            for (auto section = target->cbegin(); section != target->cend(); ++section)
+            {
+                sections.insert(section.key(), QJsonArray::fromStringList(section.value()));
+            }
+            output.insert(target.key(), sections);
+        }
+        return output;
+    }
+
+    if (operation.command == QLatin1String("owners"))
+    {
+        QJsonObject output;
+        for (const auto& fileName : operation.fileNames)
+        {
+            output.insert(fileName, QJsonArray::fromStringList(cmakeListsFile.targetsOfSourceFile(fileName)));
+        }
+        return output;
+    }
+
+    if (operation.command == QLatin1String("dump"))
+    {
+        QJsonArray output;
+        const auto blocks = cmakeListsFile.sourcesBlocks();
+        for (const auto& block : blocks)
+        {
+            QJsonArray sections;
+            for (const auto& section : block.sections)
+            {
+                sections.append(QJsonObject{
+                                    {QLatin1String("name"), section.name},
+                                    {QLatin1String("fileNames"), QJsonArray::fromStringList(section.fileNames)},
+                                });
+            }
+
+            output.append(QJsonObject{
+                              {QLatin1String("function"), block.functionName},
+                              {QLatin1String("target"), block.target},
+                              {QLatin1String("startLine"), block.startLine},
+                              {QLatin1String("endLine"), block.endLine},
+                              {QLatin1String("sections"), sections},
+                          });
+        }
+        return output;
+    }
+
+    return {};
+}
+
+} // namespace cmle::cli
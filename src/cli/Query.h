@@ -0,0 +1,19 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "Operation.h"
+#include <QJsonValue>
+
+namespace cmle::cli {
+
+// Runs a read-only command on a CMakeLists file:
+//   targets  ["target", ...]
+//   sources  {"target": {"section": ["file", ...], ...}, ...} (optionally restricted to one target and section)
+//   owners   {"file": ["target", ...], ...}
+//   dump     [{"function": ..., "target": ..., "startLine": ..., "endLine": ...,
+//              "sections": [{"name": ..., "fileNames": [...]}, ...]}, ...]
+QJsonValue runQuery(const CMakeListsFile& cmakeListsFile, const Operation& operation);
+
+} // namespace cmle::cli
@@ -0,0 +1,235 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Server.h"
+
+#include "Operation.h"
+#include "Query.h"
+#include <cmle/CMakeListsFile.h>
+#include <cmle/StandardFileBuffer.h>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <iostream>
+
+namespace cmle::cli {
+
+namespace {
+
+bool isUnchanged(const QFileInfo& fileInfo, const QDateTime& modified, qint64 size)
+{
+    return fileInfo.exists() && fileInfo.lastModified() == modified && fileInfo.size() == size;
+}
+
+} // namespace
+
+Server::Server(QObject* parent) :
+    QObject{parent}
+{
+    connect(&server_, &QLocalServer::newConnection, this, &Server::onNewConnection);
+    connect(&watcher_, &QFileSystemWatcher::fileChanged, this, &Server::onFileChanged);
+}
+
+Server::~Server() = default;
+
+bool Server::listen(const QString& name)
+{
+    server_.setSocketOptions(QLocalServer::UserAccessOption);
+
+    if (server_.listen(name))
+        return true;
+
+    // remove a stale socket of a crashed server
+    if (server_.serverError() == QAbstractSocket::AddressInUseError)
+    {
+        QLocalSocket probe;
+        probe.connectToServer(name);
+        if (!probe.waitForConnected(100))
+        {
+            QLocalServer::removeServer(name);
+            if (server_.listen(name))
+                return true;
+        }
+    }
+
+    std::cerr << "Could not listen on " << qPrintable(name) << ": " << qPrintable(server_.errorString()) << std::endl;
+    return false;
+}
+
+void Server::onNewConnection()
+{
+    while (auto socket = server_.nextPendingConnection())
+    {
+        connect(socket, &QLocalSocket::readyRead, this, &Server::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void Server::onReadyRead()
+{
+    auto socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket)
+        return;
+
+    while (socket->canReadLine())
+    {
+        const QByteArray request = socket->readLine().trimmed();
+        if (request.isEmpty())
+            continue;
+
+        const auto response = handleRequest(request);
+        socket->write(QJsonDocument{response}.toJson(QJsonDocument::Compact));
+        socket->write("\n");
+    }
+}
+
+void Server::onFileChanged(const QString& fileName)
+{
+    auto pos = models_.find(fileName);
+    if (pos == models_.end())
+        return;
+
+    // our own writes also trigger the watcher
+    const QFileInfo fileInfo{fileName};
+    if (isUnchanged(fileInfo, pos->modified, pos->size))
+    {
+        // replacing the file removes it from the watcher
+        if (!watcher_.files().contains(fileName))
+            watcher_.addPath(fileName);
+        return;
+    }
+
+    models_.erase(pos);
+    watcher_.removePath(fileName);
+}
+
+QJsonObject Server::handleRequest(const QByteArray& request)
+{
+    QJsonObject response;
+
+    auto fail = [&response](const QString& errorMessage) {
+        response.insert(QLatin1String("success"), false);
+        response.insert(QLatin1String("error"), errorMessage);
+        return response;
+    };
+
+    QJsonParseError parseError{};
+    const auto document = QJsonDocument::fromJson(request, &parseError);
+    if (parseError.error != QJsonParseError::NoError)
+        return fail(parseError.errorString());
+    if (!document.isObject())
+        return fail(QStringLiteral("Request is not a JSON object"));
+
+    const auto object = document.object();
+    if (object.contains(QLatin1String("id")))
+        response.insert(QLatin1String("id"), object.value(QLatin1String("id")));
+
+    Operation operation;
+    QString errorMessage;
+    if (!operationFromJson(object, operation, errorMessage))
+        return fail(errorMessage);
+
+    const bool query = operation.command == QLatin1String("query") || isQueryCommand(operation.command);
+    if (query)
+    {
+        if (operation.cmlFile.isEmpty())
+            return fail(QStringLiteral("No CMakeLists.txt file specified"));
+    }
+    else if (!validateOperation(operation, errorMessage))
+    {
+        return fail(errorMessage);
+    }
+
+    const auto fileName = QFileInfo{operation.cmlFile}.absoluteFilePath();
+
+    auto fileModel = model(fileName, errorMessage);
+    if (!fileModel)
+        return fail(errorMessage);
+
+    if (operation.command == QLatin1String("query"))
+    {
+        response.insert(QLatin1String("success"), true);
+        response.insert(QLatin1String("content"), QString::fromUtf8(fileModel->file->write()));
+        return response;
+    }
+
+    if (query)
+    {
+        response.insert(QLatin1String("success"), true);
+        response.insert(QLatin1String("result"), runQuery(*fileModel->file, operation));
+        return response;
+    }
+
+    const bool applied = applyOperation(*fileModel->file, operation, errorMessage);
+
+    QString saveError;
+    if (fileModel->file->hasChangedBlocks() && !save(fileName, *fileModel, saveError))
+        return fail(saveError);
+
+    if (!applied)
+        return fail(errorMessage);
+
+    response.insert(QLatin1String("success"), true);
+    return response;
+}
+
+Server::Model* Server::model(const QString& fileName, QString& errorMessage)
+{
+    const QFileInfo fileInfo{fileName};
+    if (!fileInfo.exists())
+    {
+        errorMessage = QStringLiteral("CMakeLists file does not exists");
+        return nullptr;
+    }
+
+    auto pos = models_.find(fileName);
+    if (pos != models_.end() && isUnchanged(fileInfo, pos->modified, pos->size))
+        return &*pos;
+
+    // the file info is taken before reading, so a concurrent change leads to another reload on the next request
+    StandardFileBuffer buffer{fileName};
+    if (!buffer.load())
+    {
+        errorMessage = QStringLiteral("Could not read CMakeLists file");
+        return nullptr;
+    }
+
+    auto file = QSharedPointer<CMakeListsFile>::create(buffer.content());
+    if (!file->isLoaded())
+    {
+        errorMessage = QStringLiteral("Could not parse CMakeLists file");
+        return nullptr;
+    }
+
+    pos = models_.insert(fileName, {file, fileInfo.lastModified(), fileInfo.size()});
+
+    if (!watcher_.files().contains(fileName))
+        watcher_.addPath(fileName);
+
+    return &*pos;
+}
+
+bool Server::save(const QString& fileName, Model& model, QString& errorMessage)
+{
+    StandardFileBuffer output{fileName};
+    output.setSavePolicy(SavePolicy::SkipUnchanged);
+    output.setContent(model.file->write());
+    if (!output.save())
+    {
+        // the model is ahead of the file now, drop it
+        models_.remove(fileName);
+        errorMessage = QStringLiteral("Could not write CMakeLists file");
+        return false;
+    }
+
+    const QFileInfo fileInfo{fileName};
+    model.modified = fileInfo.lastModified();
+    model.size = fileInfo.size();
+
+    if (!watcher_.files().contains(fileName))
+        watcher_.addPath(fileName);
+
+    return true;
+}
+
+} // namespace cmle::cli
@@ -0,0 +1,64 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QSharedPointer>
+
+class QLocalSocket;
+
+namespace cmle {
+
+class CMakeListsFile;
+
+namespace cli {
+
+// Serves requests on a local socket and keeps the parsed CMakeLists files in memory between requests. A model is
+// dropped as soon as its file is changed by someone else (file system watcher or changed size/modification time).
+//
+// Every request and every response is a JSON object on a single line. Requests contain the operation keys known from
+// the batch mode ("command", "file", "target", "fileNames", "sort") and an optional "id", which is copied to the
+// response. The commands "add", "del" and "ren" write the changed file in place, "query" returns the current
+// content of the file and the read-only commands of runQuery() return their result in "result".
+class Server : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Server(QObject* parent = nullptr);
+    ~Server() override;
+
+    bool listen(const QString& name);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onFileChanged(const QString& fileName);
+
+private:
+    struct Model
+    {
+        QSharedPointer<CMakeListsFile> file{};
+        QDateTime modified{};
+        qint64 size{-1};
+    };
+
+private:
+    QJsonObject handleRequest(const QByteArray& request);
+    Model* model(const QString& fileName, QString& errorMessage);
+    bool save(const QString& fileName, Model& model, QString& errorMessage);
+
+private:
+    QLocalServer server_{};
+    QFileSystemWatcher watcher_{};
+    QHash<QString, Model> models_{};
+};
+
+} // namespace cli
+
+} // namespace cmle
@@ -0,0 +1,176 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "include/cmle/core/FileIo.h"
+
+#include <fstream>
+#include <random>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CMLE_POSIX_FILES
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <filesystem>
+#endif
+
+namespace cmle::core {
+
+namespace {
+
+// the temporary files of cmle::Transaction are named alike
+constexpr std::string_view kTempSuffix = ".cmle-";
+constexpr int kTempNameLength = 6;
+constexpr int kTempNameAttempts = 100;
+
+std::string tempFileName(const std::string& path)
+{
+    static constexpr std::string_view kChars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    thread_local std::mt19937 random{std::random_device{}()};
+    std::uniform_int_distribution<size_t> pick{0, kChars.size() - 1};
+
+    std::string output = path;
+    output += kTempSuffix;
+    for (int i = 0; i < kTempNameLength; ++i)
+    {
+        output += kChars[pick(random)];
+    }
+    return output;
+}
+
+#if defined(CMLE_POSIX_FILES)
+
+bool writeAll(int fd, std::string_view content)
+{
+    while (!content.empty())
+    {
+        const ssize_t written = ::write(fd, content.data(), content.size());
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        content.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+std::string directoryOf(const std::string& path)
+{
+    const auto pos = path.find_last_of('/');
+    if (pos == std::string::npos)
+        return ".";
+    if (pos == 0)
+        return "/";
+    return path.substr(0, pos);
+}
+
+#endif
+
+} // namespace
+
+// *********************************************************************************************************************
+
+bool readFile(const std::string& path, std::string& content)
+{
+    std::ifstream input{path, std::ios::binary | std::ios::ate};
+    if (!input)
+        return false;
+
+    // directories report a size which cannot be allocated
+    const auto size = static_cast<std::streamoff>(input.tellg());
+    if (size < 0 || static_cast<unsigned long long>(size) > content.max_size() || !input.seekg(0))
+        return false;
+
+    content.resize(static_cast<size_t>(size));
+    return static_cast<bool>(input.read(content.data(), static_cast<std::streamsize>(size)));
+}
+
+#if defined(CMLE_POSIX_FILES)
+
+bool writeFileAtomically(const std::string& path, std::string_view content)
+{
+    // Like mkstemp(), but created with the permissions of a new file (0666 without the umask) for a path which does
+    // not exist yet
+    std::string temporary;
+    int fd = -1;
+    for (int attempt = 0; fd < 0 && attempt < kTempNameAttempts; ++attempt)
+    {
+        temporary = tempFileName(path);
+        fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fd < 0 && errno != EEXIST)
+            return false;
+    }
+    if (fd < 0)
+        return false;
+
+    bool ok = writeAll(fd, content);
+    struct stat status{};
+    if (ok && ::stat(path.c_str(), &status) == 0)
+        ok = ::fchmod(fd, status.st_mode & 07777) == 0;
+    ok = ok && ::fsync(fd) == 0;
+    // some file systems only report write errors on close
+    ok = ::close(fd) == 0 && ok;
+    ok = ok && ::rename(temporary.c_str(), path.c_str()) == 0;
+    if (!ok)
+    {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+
+    // The rename is only durable once the directory is synced. The file is replaced either way, so a failure is not
+    // reported.
+    const int directory = ::open(directoryOf(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (directory >= 0)
+    {
+        ::fsync(directory);
+        ::close(directory);
+    }
+    return true;
+}
+
+#else
+
+bool writeFileAtomically(const std::string& path, std::string_view content)
+{
+    namespace fs = std::filesystem;
+
+    // without POSIX the data is not synced before the rename, the file is still never left half written
+    std::string temporary;
+    std::ofstream output;
+    for (int attempt = 0; !output.is_open() && attempt < kTempNameAttempts; ++attempt)
+    {
+        temporary = tempFileName(path);
+        std::error_code error;
+        if (!fs::exists(temporary, error) && !error)
+            output.open(temporary, std::ios::binary | std::ios::trunc);
+    }
+    if (!output.is_open())
+        return false;
+
+    std::error_code error;
+    const bool written = output.write(content.data(), static_cast<std::streamsize>(content.size())).flush().good();
+    output.close();
+    if (written && !output.fail())
+    {
+        const auto status = fs::status(path, error);
+        if (fs::exists(status))
+            fs::permissions(temporary, status.permissions(), error);
+        if (!error)
+            fs::rename(temporary, path, error);
+    }
+
+    if (!written || output.fail() || error)
+    {
+        fs::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+#endif
+
+} // namespace cmle::core
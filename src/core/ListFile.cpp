@@ -0,0 +1,1477 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "include/cmle/core/ListFile.h"
+
+#include "cmake/cmListFileLexer.h"
+#include "include/cmle/core/Trace.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <utility>
+
+namespace cmle::core {
+
+namespace {
+
+constexpr std::string_view kDefaultSeparator = "\n    ";
+
+char toLower(char ch)
+{
+    return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs)
+{
+    return lhs.size() == rhs.size() &&
+            std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char l, char r) { return toLower(l) == toLower(r); });
+}
+
+template<typename... T>
+inline bool compareStrings(std::string_view string, T... strings)
+{
+    return (equalsIgnoreCase(string, strings) || ...);
+}
+
+// Character an escape sequence stands for, indexed by the character after the backslash
+constexpr std::array<char, 128> unescapeTable = []() {
+    std::array<char, 128> table{};
+    for (size_t i = 0; i < table.size(); ++i)
+        table[i] = static_cast<char>(i);
+    table['n'] = '\n';
+    table['r'] = '\r';
+    table['t'] = '\t';
+    return table;
+}();
+
+// Values are unescaped while parsing and never changed afterwards. Copies of a ListFile share its arguments and are
+// read from other threads, so there must be no lazily filled cache.
+std::string unescape(std::string_view value)
+{
+    size_t i = value.find('\\');
+    if (i == std::string_view::npos || i + 1 == value.size())
+        return std::string{value};
+
+    std::string output;
+    output.reserve(value.size());
+    output.append(value.substr(0, i));
+    for (; i < value.size(); ++i)
+    {
+        if (value[i] != '\\' || i + 1 == value.size())
+        {
+            output += value[i];
+            continue;
+        }
+
+        const auto ch = static_cast<unsigned char>(value[++i]);
+        output += ch < unescapeTable.size() ? unescapeTable[ch] : static_cast<char>(ch);
+    }
+    return output;
+}
+
+bool needsQuotation(std::string_view fileName)
+{
+    return fileName.find(' ') != std::string_view::npos;
+}
+
+// Character written after a backslash for ch, 0 if ch is written as is. Semicolons and dollar signs are not escaped,
+// the value does not tell a list separator or variable reference from an escaped one.
+char escapeFor(char ch, bool quoted)
+{
+    switch (ch)
+    {
+        case '\\':
+        case '"':
+            return ch;
+        case '\n':
+            return quoted ? 0 : 'n';
+        case '\r':
+            return quoted ? 0 : 'r';
+        case '\t':
+            return quoted ? 0 : 't';
+        case ' ':
+        case '(':
+        case ')':
+        case '#':
+            return quoted ? 0 : ch;
+        default:
+            return 0;
+    }
+}
+
+// text of a file name argument as written to the file
+std::string argumentText(std::string_view fileName, bool quoted)
+{
+    std::string output;
+    output.reserve(fileName.size() + 2);
+    if (quoted)
+        output += '"';
+    for (char ch : fileName)
+    {
+        if (const char escape = escapeFor(ch, quoted))
+        {
+            output += '\\';
+            output += escape;
+        }
+        else
+        {
+            output += ch;
+        }
+    }
+    if (quoted)
+        output += '"';
+    return output;
+}
+
+// the indentation of a separator, without comments
+std::string_view indentation(std::string_view separator)
+{
+    const auto newline = separator.rfind('\n');
+    const auto start = newline != std::string_view::npos ? newline : 0;
+    const auto end = separator.find_first_not_of(" \t\r", newline != std::string_view::npos ? newline + 1 : 0);
+    const auto output = separator.substr(start, end != std::string_view::npos ? end - start : end);
+    return !output.empty() ? output : kDefaultSeparator;
+}
+
+std::string_view extractPath(std::string_view fileName)
+{
+    const auto pos = fileName.find_last_of('/');
+    if (pos == std::string_view::npos)
+        return {};
+    if (pos == 0)
+        return fileName.substr(0, 1);
+    return fileName.substr(0, pos);
+}
+
+// Makes pointer the only owner of its object, which is copied if it is still shared with a copy of the file. The count
+// cannot grow concurrently, new copies are only made from the object being edited. It can drop concurrently when a copy
+// is destroyed on another thread, use_count() is only a relaxed load though. The fence pairs with the release of that
+// reference, so the reads of the other thread happen before the object is changed here.
+template<typename T>
+T& detachShared(std::shared_ptr<T>& pointer)
+{
+    if (pointer.use_count() > 1)
+        pointer = std::make_shared<T>(*pointer);
+    else
+        std::atomic_thread_fence(std::memory_order_acquire);
+    return *pointer;
+}
+
+} // namespace
+
+// *********************************************************************************************************************
+
+class ListFilePrivate
+{
+public:
+    struct Argument
+    {
+        // raw text in front of the argument, including comments
+        std::string separator;
+        // raw text of the argument, including quotes or brackets
+        std::string text;
+        std::string value;
+        bool quoted{false};
+    };
+
+    struct Function
+    {
+        std::string name;
+        size_t begin{};
+        size_t end{};
+        int startLine{};
+        int endLine{};
+        // name up to and including the left parenthesis
+        std::string head;
+        std::vector<Argument> arguments;
+        std::string trailingSpace;
+    };
+
+    // The file names of a section in chunks, which are shared with the copies of the file like the functions. An edit
+    // copies the list of chunk pointers and the chunk it changes, never the whole section. Chunks are never empty.
+    class FileList
+    {
+    public:
+        using Chunk = std::vector<Argument>;
+        using Chunks = std::vector<std::shared_ptr<Chunk>>;
+
+        class const_iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Argument;
+            using difference_type = ptrdiff_t;
+            using pointer = const Argument*;
+            using reference = const Argument&;
+
+            const_iterator(const Chunks* chunks, size_t chunk) :
+                chunks_{chunks},
+                chunk_{chunk}
+            {
+            }
+
+            reference operator*() const { return (*(*chunks_)[chunk_])[offset_]; }
+            pointer operator->() const { return &**this; }
+
+            const_iterator& operator++()
+            {
+                if (++offset_ == (*chunks_)[chunk_]->size())
+                {
+                    ++chunk_;
+                    offset_ = 0;
+                }
+                return *this;
+            }
+
+            bool operator==(const const_iterator& other) const
+            {
+                return chunk_ == other.chunk_ && offset_ == other.offset_;
+            }
+            bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+        private:
+            const Chunks* chunks_;
+            size_t chunk_;
+            size_t offset_{0};
+        };
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        const_iterator begin() const { return {chunks.get(), 0}; }
+        const_iterator end() const { return {chunks.get(), chunks ? chunks->size() : 0}; }
+        const Argument& operator[](size_t index) const;
+        const Argument& back() const { return chunks->back()->back(); }
+
+        // index of the first file name ordered after argument, the list has to be sorted by less
+        template<typename Less>
+        size_t upperBound(const Argument& argument, Less less) const;
+
+        Argument& edit(size_t index);
+        void insert(size_t index, Argument argument);
+        void pushBack(Argument argument);
+        void erase(size_t index);
+        void assign(std::vector<Argument> arguments);
+
+    private:
+        static constexpr size_t kChunkSize = 64;
+
+        // chunk index and offset in the chunk
+        std::pair<size_t, size_t> locate(size_t index) const;
+        Chunk& editChunk(size_t chunk);
+
+        std::shared_ptr<Chunks> chunks;
+        size_t count{0};
+    };
+
+    struct Section
+    {
+        // the file list of add_library() etc. has no name argument
+        Argument nameArgument;
+        FileList fileNames;
+        // directories of the file names read from the file, not changed by edits
+        std::shared_ptr<const std::vector<std::string>> commonPrefixes;
+        // With SortSectionPolicy::Sort the file names are sorted on first use and kept in order by the edits after that
+        bool sorted{false};
+
+        void finalize();
+        ptrdiff_t indexOf(std::string_view fileName) const;
+        // compare is the order of ListFile::setFileNameCompare(), only used if sorted
+        void addFileName(std::string_view fileName, bool sorted, FileNameCompare compare);
+        void renameFile(size_t index, std::string_view newFileName, bool sorted, FileNameCompare compare);
+        void removeFile(size_t index, bool sorted, FileNameCompare compare);
+        void sortFileNames(FileNameCompare compare);
+    };
+
+    struct SourcesFunction
+    {
+        struct Slot
+        {
+            ptrdiff_t sectionIndex{-1};
+            Argument argument;
+        };
+
+        std::string name;
+        std::string target;
+        size_t begin{};
+        size_t end{};
+        int startLine{};
+        int endLine{};
+        std::string head;
+        std::vector<Slot> arguments;
+        std::vector<Section> sections;
+        std::string trailingSpace;
+        std::string defaultInsertSection;
+        bool dirty{false};
+
+        Section& addSection(Argument nameArgument);
+        // calls sink with every piece of the written function in order
+        template<typename Sink>
+        void serialize(Sink& sink) const;
+    };
+
+    // the parse result, never changed after construction and shared by all copies
+    struct Content
+    {
+        // keeps the memory text refers to alive, the text is read in place and never copied as a whole
+        std::shared_ptr<const void> owner;
+        std::string_view text;
+        bool loaded{false};
+        int errorLine{0};
+        std::map<std::string, std::vector<size_t>, std::less<>> sourcesFunctionsIndex;
+        std::vector<std::string> subdirectories;
+    };
+
+    // Where to insert a file, a new section named after the default insert section has to be added if sectionIndex is
+    // -1.
+    struct InsertLocation
+    {
+        size_t functionIndex{};
+        ptrdiff_t sectionIndex{-1};
+    };
+
+public:
+    ListFilePrivate(std::string_view text, std::shared_ptr<const void> owner);
+
+    const SourcesFunction& function(size_t index) const { return *sourcesFunctions[index]; }
+    SourcesFunction& detach(size_t index);
+
+    InsertLocation findBestInsertSection(const std::vector<size_t>& indices, std::string_view fileName,
+                                         std::string_view sectionName) const;
+
+    static ptrdiff_t commonPrefixScore(std::string_view prefix, const Section& section);
+
+    template<typename Edit>
+    bool editFile(std::string_view target, std::string_view fileName, Edit edit);
+
+    // calls sink with every piece of the written file in order, the unchanged text between the edited functions in one
+    template<typename Sink>
+    void serialize(Sink& sink) const;
+
+public:
+    std::shared_ptr<const Content> content;
+    SortSectionPolicy sortSectionPolicy{SortSectionPolicy::NoSort};
+    FileNameCompare fileNameCompare{nullptr};
+    // Shared with the copies of the file, a function is copied before it is edited, see detach()
+    std::vector<std::shared_ptr<SourcesFunction>> sourcesFunctions;
+};
+
+namespace {
+
+struct FileNameLess
+{
+    FileNameCompare compare;
+
+    bool operator()(const ListFilePrivate::Argument& lhs, const ListFilePrivate::Argument& rhs) const
+    {
+        const bool lhsHasSlash = lhs.value.find_first_of("/\\") != std::string::npos;
+        const bool rhsHasSlash = rhs.value.find_first_of("/\\") != std::string::npos;
+        if (lhsHasSlash != rhsHasSlash)
+            return lhsHasSlash;
+
+        if (compare)
+            return compare(lhs.value, rhs.value) < 0;
+
+        // a locale independent approximation of QString::localeAwareCompare() for file names
+        const auto lessIgnoreCase = [](char l, char r) { return toLower(l) < toLower(r); };
+        if (std::lexicographical_compare(lhs.value.begin(), lhs.value.end(), rhs.value.begin(), rhs.value.end(),
+                                         lessIgnoreCase))
+            return true;
+        if (std::lexicographical_compare(rhs.value.begin(), rhs.value.end(), lhs.value.begin(), lhs.value.end(),
+                                         lessIgnoreCase))
+            return false;
+        return lhs.value < rhs.value;
+    }
+};
+
+// Reads the functions of a file into a ListFilePrivate, only used while constructing it
+class Reader
+{
+public:
+    Reader(ListFilePrivate::Content& content, std::vector<std::shared_ptr<ListFilePrivate::SourcesFunction>>& output);
+
+    bool parse(std::vector<ListFilePrivate::Function>& functions);
+    void readInFunctions(std::vector<ListFilePrivate::Function>& functions);
+
+private:
+    using Argument = ListFilePrivate::Argument;
+    using Function = ListFilePrivate::Function;
+    using Section = ListFilePrivate::Section;
+    using SourcesFunction = ListFilePrivate::SourcesFunction;
+
+    bool readFunction(cmListFileLexer* lexer, Function& function);
+
+    SourcesFunction readTargetSourcesFunction(Function& function) const;
+    SourcesFunction readAddTargetFunction(Function& function) const;
+    void readSubdirectory(const Function& function);
+
+    size_t offset(const cmListFileLexer_Token* token) const;
+
+private:
+    ListFilePrivate::Content& content;
+    std::vector<std::shared_ptr<SourcesFunction>>& sourcesFunctions;
+    std::vector<size_t> lineStarts;
+    int64_t tokenCount{0};
+};
+
+Reader::Reader(ListFilePrivate::Content& _content,
+               std::vector<std::shared_ptr<ListFilePrivate::SourcesFunction>>& output) :
+    content{_content},
+    sourcesFunctions{output}
+{
+    const auto& text = content.text;
+    lineStarts.push_back(0);
+    for (size_t pos = text.find('\n'); pos != std::string_view::npos; pos = text.find('\n', pos + 1))
+    {
+        lineStarts.push_back(pos + 1);
+    }
+}
+
+size_t Reader::offset(const cmListFileLexer_Token* token) const
+{
+    // the lexer counts lines and columns (in bytes) from 1
+    return lineStarts[static_cast<size_t>(token->line - 1)] + static_cast<size_t>(token->column - 1);
+}
+
+bool Reader::parse(std::vector<Function>& functions)
+{
+    cmListFileLexer* lexer = cmListFileLexer_New();
+    if (!lexer)
+        return false;
+
+    // not copied, flex reads the text through its fixed-size input buffer one chunk at a time
+    if (!cmListFileLexer_SetString(lexer, content.text.data(), content.text.size()))
+    {
+        cmListFileLexer_Delete(lexer);
+        return false;
+    }
+
+    bool ok = true;
+    bool haveNewline = true;
+    while (cmListFileLexer_Token* token = cmListFileLexer_Scan(lexer))
+    {
+        ++tokenCount;
+
+        if (token->type == cmListFileLexer_Token_Newline)
+        {
+            haveNewline = true;
+        }
+        else if (token->type == cmListFileLexer_Token_Identifier && haveNewline)
+        {
+            haveNewline = false;
+
+            Function function;
+            function.name.assign(token->text, static_cast<size_t>(token->length));
+            std::transform(function.name.begin(), function.name.end(), function.name.begin(), toLower);
+            function.begin = offset(token);
+            function.startLine = token->line;
+
+            if (!readFunction(lexer, function))
+            {
+                content.errorLine = static_cast<int>(cmListFileLexer_GetCurrentLine(lexer));
+                ok = false;
+                break;
+            }
+
+            functions.push_back(std::move(function));
+        }
+    }
+
+    cmListFileLexer_Delete(lexer);
+
+    trace::counter("bytesLexed", static_cast<int64_t>(content.text.size()));
+    trace::counter("tokensLexed", tokenCount);
+    trace::counter("functionsParsed", static_cast<int64_t>(functions.size()));
+
+    return ok;
+}
+
+bool Reader::readFunction(cmListFileLexer* lexer, Function& function)
+{
+    const auto& text = content.text;
+
+    // Command name has already been parsed.
+    cmListFileLexer_Token* token{};
+
+    while ((token = cmListFileLexer_Scan(lexer)))
+    {
+        ++tokenCount;
+        if (token->type == cmListFileLexer_Token_ParenLeft)
+            break;
+        if (token->type != cmListFileLexer_Token_Space)
+            return false;
+    }
+    if (!token)
+        return false;
+
+    size_t end = offset(token) + 1;
+    function.head = text.substr(function.begin, end - function.begin);
+
+    // quoted and bracket arguments end where the next token starts
+    Argument* openArgument{};
+    auto startToken = [&](size_t start) {
+        if (openArgument)
+        {
+            openArgument->text = text.substr(end, start - end);
+            openArgument = nullptr;
+            end = start;
+        }
+    };
+
+    auto addArgument = [&](size_t start, size_t length, std::string value, bool quoted) {
+        Argument argument{std::string{text.substr(end, start - end)}, {}, std::move(value), quoted};
+        function.arguments.push_back(std::move(argument));
+        if (length > 0)
+        {
+            function.arguments.back().text = text.substr(start, length);
+            end = start + length;
+        }
+        else
+        {
+            openArgument = &function.arguments.back();
+            end = start;
+        }
+    };
+
+    int parenthesis = 1;
+    while ((token = cmListFileLexer_Scan(lexer)))
+    {
+        ++tokenCount;
+
+        const size_t start = offset(token);
+        startToken(start);
+
+        switch (token->type)
+        {
+            case cmListFileLexer_Token_ParenRight:
+                if (--parenthesis == 0)
+                {
+                    function.trailingSpace = text.substr(end, start - end);
+                    function.end = start + 1;
+                    function.endLine = token->line;
+                    return true;
+                }
+                addArgument(start, 1, {token->text, static_cast<size_t>(token->length)}, false);
+                break;
+
+            case cmListFileLexer_Token_ParenLeft:
+                ++parenthesis;
+                addArgument(start, 1, {token->text, static_cast<size_t>(token->length)}, false);
+                break;
+
+            case cmListFileLexer_Token_Identifier:
+            case cmListFileLexer_Token_ArgumentUnquoted:
+                addArgument(start, static_cast<size_t>(token->length),
+                            unescape({token->text, static_cast<size_t>(token->length)}), false);
+                break;
+
+            case cmListFileLexer_Token_ArgumentBracket:
+                addArgument(start, 0, {token->text, static_cast<size_t>(token->length)}, false);
+                break;
+
+            case cmListFileLexer_Token_ArgumentQuoted:
+                addArgument(start, 0, unescape({token->text, static_cast<size_t>(token->length)}), true);
+                break;
+
+            case cmListFileLexer_Token_Space:
+            case cmListFileLexer_Token_Newline:
+            case cmListFileLexer_Token_CommentBracket:
+                // part of the separator of the next argument
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    return false;
+}
+
+void Reader::readInFunctions(std::vector<Function>& functions)
+{
+    CMLE_CORE_TRACE_SCOPE("readInFunctions");
+
+    for (auto& function : functions)
+    {
+        SourcesFunction sourcesFunction;
+
+        if (compareStrings(function.name, "add_subdirectory"))
+        {
+            readSubdirectory(function);
+            continue;
+        }
+        else if (compareStrings(function.name, "target_sources"))
+        {
+            sourcesFunction = readTargetSourcesFunction(function);
+        }
+        else if (compareStrings(function.name,
+                                "add_executable",
+                                "add_library",
+                                "qt_add_executable",
+                                "qt_add_library",
+                                "qt6_add_executable",
+                                "qt6_add_library"))
+        {
+            sourcesFunction = readAddTargetFunction(function);
+        }
+
+        if (sourcesFunction.target.empty())
+            continue;
+
+        sourcesFunction.name = std::move(function.name);
+        sourcesFunction.begin = function.begin;
+        sourcesFunction.end = function.end;
+        sourcesFunction.startLine = function.startLine;
+        sourcesFunction.endLine = function.endLine;
+        sourcesFunction.head = std::move(function.head);
+        sourcesFunction.trailingSpace = std::move(function.trailingSpace);
+
+        for (auto& section : sourcesFunction.sections)
+        {
+            section.finalize();
+        }
+
+        content.sourcesFunctionsIndex[sourcesFunction.target].push_back(sourcesFunctions.size());
+        sourcesFunctions.push_back(std::make_shared<SourcesFunction>(std::move(sourcesFunction)));
+    }
+
+    trace::counter("sourcesFunctions", static_cast<int64_t>(sourcesFunctions.size()));
+}
+
+ListFilePrivate::SourcesFunction Reader::readTargetSourcesFunction(Function& function) const
+{
+    SourcesFunction info;
+
+    auto& args = function.arguments;
+    auto it = args.begin();
+    if (it == args.end())
+        return info;
+
+    info.target = it->value;
+    info.arguments.push_back({-1, std::move(*it)});
+
+    Section* currentSection{};
+
+    for (++it; it != args.end(); ++it)
+    {
+        if (!it->quoted && compareStrings(it->value, "INTERFACE", "PUBLIC", "PRIVATE"))
+            currentSection = &info.addSection(std::move(*it));
+        else if (currentSection)
+            currentSection->fileNames.pushBack(std::move(*it));
+    }
+
+    info.defaultInsertSection = "PRIVATE";
+
+    return info;
+}
+
+ListFilePrivate::SourcesFunction Reader::readAddTargetFunction(Function& function) const
+{
+    SourcesFunction info;
+
+    auto& args = function.arguments;
+    auto it = args.begin();
+    if (it == args.end())
+        return info;
+
+    info.target = it->value;
+    info.arguments.push_back({-1, std::move(*it)});
+
+    Section* filesSection{};
+
+    for (++it; it != args.end(); ++it)
+    {
+        if (!filesSection)
+        {
+            if (!it->quoted &&
+                    compareStrings(it->value,
+                                   "WIN32", "MACOSX_BUNDLE", "EXCLUDE_FROM_ALL",
+                                   "STATIC", "SHARED", "MODULE", "INTERFACE", "OBJECT",
+                                   "MANUAL_FINALIZATION"))
+            {
+                info.arguments.push_back({-1, std::move(*it)});
+                continue;
+            }
+
+            if (!it->quoted && compareStrings(it->value, "CLASS_NAME", "OUTPUT_TARGETS") && it + 1 != args.end())
+            {
+                info.arguments.push_back({-1, std::move(*it)});
+                ++it;
+                info.arguments.push_back({-1, std::move(*it)});
+                continue;
+            }
+
+            filesSection = &info.addSection({});
+        }
+
+        if (!it->value.empty())
+            filesSection->fileNames.pushBack(std::move(*it));
+    }
+
+    return info;
+}
+
+void Reader::readSubdirectory(const Function& function)
+{
+    if (function.arguments.empty())
+        return;
+
+    const auto& sourceDir = function.arguments.front().value;
+    if (sourceDir.empty() || sourceDir.find("${") != std::string::npos || sourceDir.find("$<") != std::string::npos)
+        return;
+
+    content.subdirectories.push_back(sourceDir);
+}
+
+} // namespace
+
+// *********************************************************************************************************************
+
+std::pair<size_t, size_t> ListFilePrivate::FileList::locate(size_t index) const
+{
+    size_t chunk = 0;
+    while (index >= (*chunks)[chunk]->size())
+    {
+        index -= (*chunks)[chunk]->size();
+        ++chunk;
+    }
+    return {chunk, index};
+}
+
+ListFilePrivate::FileList::Chunk& ListFilePrivate::FileList::editChunk(size_t chunk)
+{
+    // the list of chunks first, the chunk can only be owned alone by a list owned alone
+    return detachShared((detachShared(chunks))[chunk]);
+}
+
+const ListFilePrivate::Argument& ListFilePrivate::FileList::operator[](size_t index) const
+{
+    const auto [chunk, offset] = locate(index);
+    return (*(*chunks)[chunk])[offset];
+}
+
+template<typename Less>
+size_t ListFilePrivate::FileList::upperBound(const Argument& argument, Less less) const
+{
+    if (empty())
+        return 0;
+
+    // the first chunk ending with a larger file name holds the position, comparing file names can be expensive so
+    // the chunks are searched by their last file name first
+    const auto chunk = std::partition_point(chunks->begin(), chunks->end(),
+                                            [&](const auto& current) { return !less(argument, current->back()); });
+
+    size_t index = 0;
+    for (auto it = chunks->begin(); it != chunk; ++it)
+    {
+        index += (*it)->size();
+    }
+    if (chunk == chunks->end())
+        return index;
+    return index + static_cast<size_t>(std::upper_bound((*chunk)->begin(), (*chunk)->end(), argument, less) -
+                                       (*chunk)->begin());
+}
+
+ListFilePrivate::Argument& ListFilePrivate::FileList::edit(size_t index)
+{
+    const auto [chunk, offset] = locate(index);
+    return editChunk(chunk)[offset];
+}
+
+void ListFilePrivate::FileList::insert(size_t index, Argument argument)
+{
+    if (index == count)
+    {
+        pushBack(std::move(argument));
+        return;
+    }
+
+    const auto [chunk, offset] = locate(index);
+    auto& edited = editChunk(chunk);
+    edited.insert(edited.begin() + static_cast<ptrdiff_t>(offset), std::move(argument));
+    ++count;
+
+    if (edited.size() < 2 * kChunkSize)
+        return;
+
+    // split a full chunk in halves, so following inserts copy small chunks again
+    auto second = std::make_shared<Chunk>(std::make_move_iterator(edited.begin() + kChunkSize),
+                                          std::make_move_iterator(edited.end()));
+    edited.resize(kChunkSize);
+    chunks->insert(chunks->begin() + static_cast<ptrdiff_t>(chunk) + 1, std::move(second));
+}
+
+void ListFilePrivate::FileList::pushBack(Argument argument)
+{
+    if (!chunks)
+        chunks = std::make_shared<Chunks>();
+
+    ++count;
+    if (chunks->empty() || chunks->back()->size() >= kChunkSize)
+    {
+        auto& list = detachShared(chunks);
+        list.push_back(std::make_shared<Chunk>());
+        list.back()->push_back(std::move(argument));
+        return;
+    }
+
+    editChunk(chunks->size() - 1).push_back(std::move(argument));
+}
+
+void ListFilePrivate::FileList::erase(size_t index)
+{
+    const auto [chunk, offset] = locate(index);
+    auto& edited = editChunk(chunk);
+    edited.erase(edited.begin() + static_cast<ptrdiff_t>(offset));
+    --count;
+
+    if (edited.empty())
+        chunks->erase(chunks->begin() + static_cast<ptrdiff_t>(chunk));
+}
+
+void ListFilePrivate::FileList::assign(std::vector<Argument> arguments)
+{
+    auto list = std::make_shared<Chunks>();
+    list->reserve((arguments.size() + kChunkSize - 1) / kChunkSize);
+    for (size_t i = 0; i < arguments.size(); i += kChunkSize)
+    {
+        const auto first = arguments.begin() + static_cast<ptrdiff_t>(i);
+        const auto last = arguments.begin() + static_cast<ptrdiff_t>(std::min(i + kChunkSize, arguments.size()));
+        list->push_back(std::make_shared<Chunk>(std::make_move_iterator(first), std::make_move_iterator(last)));
+    }
+
+    chunks = std::move(list);
+    count = arguments.size();
+}
+
+// *********************************************************************************************************************
+
+void ListFilePrivate::Section::finalize()
+{
+    std::vector<std::string> prefixes;
+    for (const auto& fileName : fileNames)
+    {
+        const std::string path{extractPath(fileName.value)};
+        if (std::find(prefixes.begin(), prefixes.end(), path) == prefixes.end())
+            prefixes.push_back(path);
+    }
+
+    if (!prefixes.empty())
+        commonPrefixes = std::make_shared<const std::vector<std::string>>(std::move(prefixes));
+}
+
+ptrdiff_t ListFilePrivate::Section::indexOf(std::string_view fileName) const
+{
+    ptrdiff_t index = 0;
+    for (const auto& argument : fileNames)
+    {
+        if (argument.value == fileName)
+            return index;
+        ++index;
+    }
+    return -1;
+}
+
+void ListFilePrivate::Section::addFileName(std::string_view fileName, bool _sorted, FileNameCompare compare)
+{
+    const bool quoted = needsQuotation(fileName);
+    const auto separator = !fileNames.empty() ? indentation(fileNames.back().separator) : kDefaultSeparator;
+    Argument argument{std::string{separator}, argumentText(fileName, quoted), std::string{fileName}, quoted};
+
+    if (!_sorted)
+    {
+        fileNames.pushBack(std::move(argument));
+        sorted = false;
+        return;
+    }
+
+    sortFileNames(compare);
+    const size_t pos = fileNames.upperBound(argument, FileNameLess{compare});
+    fileNames.insert(pos, std::move(argument));
+}
+
+void ListFilePrivate::Section::renameFile(size_t index, std::string_view newFileName, bool _sorted,
+                                          FileNameCompare compare)
+{
+    auto rename = [&newFileName](Argument& fileName) {
+        fileName.quoted = fileName.quoted || needsQuotation(newFileName);
+        fileName.text = argumentText(newFileName, fileName.quoted);
+        fileName.value = newFileName;
+    };
+
+    if (!_sorted)
+    {
+        rename(fileNames.edit(index));
+        sorted = false;
+        return;
+    }
+
+    // the first use sorts the section, which may move the file
+    if (!sorted)
+    {
+        const std::string oldFileName = fileNames[index].value;
+        sortFileNames(compare);
+        index = static_cast<size_t>(indexOf(oldFileName));
+    }
+
+    // move the renamed file to its place, the files in between are not touched
+    Argument renamed = fileNames[index];
+    rename(renamed);
+    fileNames.erase(index);
+    const size_t pos = fileNames.upperBound(renamed, FileNameLess{compare});
+    fileNames.insert(pos, std::move(renamed));
+}
+
+void ListFilePrivate::Section::removeFile(size_t index, bool _sorted, FileNameCompare compare)
+{
+    fileNames.erase(index);
+    // removing keeps the order, only a section not sorted yet needs it
+    if (_sorted)
+        sortFileNames(compare);
+}
+
+void ListFilePrivate::Section::sortFileNames(FileNameCompare compare)
+{
+    if (sorted)
+        return;
+
+    sorted = true;
+    // most files are sorted already, they do not need a copy of the section
+    if (std::is_sorted(fileNames.begin(), fileNames.end(), FileNameLess{compare}))
+        return;
+
+    CMLE_CORE_TRACE_SCOPE("sortFileNames");
+    std::vector<Argument> output{fileNames.begin(), fileNames.end()};
+    std::sort(output.begin(), output.end(), FileNameLess{compare});
+    fileNames.assign(std::move(output));
+}
+
+ListFilePrivate::Section& ListFilePrivate::SourcesFunction::addSection(Argument nameArgument)
+{
+    arguments.push_back({static_cast<ptrdiff_t>(sections.size()), {}});
+    sections.push_back({std::move(nameArgument), {}, {}, false});
+    return sections.back();
+}
+
+template<typename Sink>
+void ListFilePrivate::SourcesFunction::serialize(Sink& sink) const
+{
+    sink(head);
+
+    for (const auto& slot : arguments)
+    {
+        if (slot.sectionIndex == -1)
+        {
+            sink(slot.argument.separator);
+            sink(slot.argument.text);
+            continue;
+        }
+
+        const auto& section = sections[static_cast<size_t>(slot.sectionIndex)];
+        if (!section.nameArgument.text.empty())
+        {
+            sink(section.nameArgument.separator);
+            sink(section.nameArgument.text);
+        }
+        for (const auto& fileName : section.fileNames)
+        {
+            sink(fileName.separator);
+            sink(fileName.text);
+        }
+    }
+
+    sink(trailingSpace);
+    sink(std::string_view{")"});
+}
+
+// *********************************************************************************************************************
+
+ListFilePrivate::ListFilePrivate(std::string_view text, std::shared_ptr<const void> owner)
+{
+    auto parsed = std::make_shared<Content>();
+    parsed->owner = std::move(owner);
+    parsed->text = text;
+
+    Reader reader{*parsed, sourcesFunctions};
+    std::vector<Function> functions;
+    parsed->loaded = reader.parse(functions);
+    if (parsed->loaded)
+        reader.readInFunctions(functions);
+
+    content = std::move(parsed);
+}
+
+ListFilePrivate::SourcesFunction& ListFilePrivate::detach(size_t index)
+{
+    // Shared with a copy of the file, which must not see the edit. The copy shares the file lists of all sections.
+    return detachShared(sourcesFunctions[index]);
+}
+
+ListFilePrivate::InsertLocation ListFilePrivate::findBestInsertSection(const std::vector<size_t>& indices,
+                                                                       std::string_view fileName,
+                                                                       std::string_view sectionName) const
+{
+    CMLE_CORE_TRACE_SCOPE("findBestInsertSection");
+
+    // the section sharing the longest directory prefix with the file, of the ones named sectionName if given
+    const auto parentPath = extractPath(fileName);
+
+    InsertLocation output{indices.front(), -1};
+    ptrdiff_t bestScore = std::numeric_limits<ptrdiff_t>::min();
+
+    for (size_t idx : indices)
+    {
+        const auto& sections = function(idx).sections;
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            if (!sectionName.empty() && !equalsIgnoreCase(sections[i].nameArgument.value, sectionName))
+                continue;
+
+            const auto score = commonPrefixScore(parentPath, sections[i]);
+            if (score > bestScore)
+            {
+                output = {idx, static_cast<ptrdiff_t>(i)};
+                bestScore = score;
+            }
+        }
+    }
+
+    return output;
+}
+
+ptrdiff_t ListFilePrivate::commonPrefixScore(std::string_view prefix, const Section& section)
+{
+    if (!section.commonPrefixes)
+        return -1;
+
+    ptrdiff_t bestScore = 0;
+    for (const auto& path : *section.commonPrefixes)
+    {
+        const auto mismatch = std::mismatch(prefix.begin(), prefix.end(), path.begin(), path.end());
+        const auto cpl = mismatch.first - prefix.begin();
+
+        if (mismatch.first == prefix.end() && mismatch.second == path.end()) // perfect match
+            return std::numeric_limits<ptrdiff_t>::max();
+
+        bestScore = std::max(bestScore, cpl);
+    }
+    return bestScore;
+}
+
+template<typename Sink>
+void ListFilePrivate::serialize(Sink& sink) const
+{
+    const auto text = content->text;
+
+    size_t pos = 0;
+    for (const auto& function : sourcesFunctions)
+    {
+        if (!function->dirty)
+            continue;
+
+        sink(text.substr(pos, function->begin - pos));
+        function->serialize(sink);
+        pos = function->end;
+    }
+
+    sink(text.substr(pos));
+}
+
+template<typename Edit>
+bool ListFilePrivate::editFile(std::string_view target, std::string_view fileName, Edit edit)
+{
+    const auto pos = content->sourcesFunctionsIndex.find(target);
+    if (pos == content->sourcesFunctionsIndex.end())
+        return false;
+
+    // the first section containing the file in every function of the target, functions are only copied if they do
+    bool changed = false;
+    for (size_t idx : pos->second)
+    {
+        const auto& sections = function(idx).sections;
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            const auto index = sections[i].indexOf(fileName);
+            if (index == -1)
+                continue;
+
+            auto& editedFunction = detach(idx);
+            edit(editedFunction.sections[i], static_cast<size_t>(index));
+            editedFunction.dirty = true;
+            changed = true;
+            break;
+        }
+    }
+
+    return changed;
+}
+
+// *********************************************************************************************************************
+
+ListFile::ListFile(std::string content)
+{
+    auto owner = std::make_shared<const std::string>(std::move(content));
+    const std::string_view text{*owner};
+    d_ = std::make_unique<ListFilePrivate>(text, std::move(owner));
+}
+
+ListFile::ListFile(std::string_view content, std::shared_ptr<const void> owner) :
+    d_{std::make_unique<ListFilePrivate>(content, std::move(owner))}
+{
+}
+
+ListFile::ListFile(const ListFile& other) :
+    d_{std::make_unique<ListFilePrivate>(*other.d_)}
+{
+}
+
+ListFile& ListFile::operator=(const ListFile& other)
+{
+    if (this != &other)
+        *d_ = *other.d_;
+    return *this;
+}
+
+ListFile::ListFile(ListFile&& other) noexcept = default;
+
+ListFile& ListFile::operator=(ListFile&& other) noexcept = default;
+
+ListFile::~ListFile() = default;
+
+bool ListFile::isLoaded() const
+{
+    return d_->content->loaded;
+}
+
+int ListFile::errorLine() const
+{
+    return d_->content->errorLine;
+}
+
+void ListFile::setSortSectionPolicy(SortSectionPolicy sortSectionPolicy)
+{
+    d_->sortSectionPolicy = sortSectionPolicy;
+}
+
+SortSectionPolicy ListFile::sortSectionPolicy() const
+{
+    return d_->sortSectionPolicy;
+}
+
+void ListFile::setFileNameCompare(FileNameCompare compare)
+{
+    if (compare == d_->fileNameCompare)
+        return;
+
+    d_->fileNameCompare = compare;
+
+    // sections sorted in the previous order are sorted again on their next edit
+    for (size_t idx = 0; idx < d_->sourcesFunctions.size(); ++idx)
+    {
+        const auto& sections = d_->function(idx).sections;
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            if (sections[i].sorted)
+                d_->detach(idx).sections[i].sorted = false;
+        }
+    }
+}
+
+bool ListFile::hasChangedBlocks() const
+{
+    return std::any_of(d_->sourcesFunctions.begin(), d_->sourcesFunctions.end(),
+                       [](const auto& function) { return function->dirty; });
+}
+
+bool ListFile::hasTarget(std::string_view target) const
+{
+    return d_->content->sourcesFunctionsIndex.find(target) != d_->content->sourcesFunctionsIndex.end();
+}
+
+bool ListFile::addSourceFile(std::string_view target, std::string_view fileName, std::string_view sectionName)
+{
+    const auto pos = d_->content->sourcesFunctionsIndex.find(target);
+    if (pos == d_->content->sourcesFunctionsIndex.end())
+        return false;
+
+    const auto location = d_->findBestInsertSection(pos->second, fileName, sectionName);
+
+    auto& function = d_->detach(location.functionIndex);
+    auto& section = location.sectionIndex != -1
+            ? function.sections[static_cast<size_t>(location.sectionIndex)]
+            : function.addSection({std::string{kDefaultSeparator}, function.defaultInsertSection,
+                                   function.defaultInsertSection, false});
+
+    section.addFileName(fileName, d_->sortSectionPolicy == SortSectionPolicy::Sort, d_->fileNameCompare);
+
+    function.dirty = true;
+    return true;
+}
+
+bool ListFile::renameSourceFile(std::string_view target, std::string_view oldFileName, std::string_view newFileName)
+{
+    const bool sorted = d_->sortSectionPolicy == SortSectionPolicy::Sort;
+    return d_->editFile(target, oldFileName, [&](ListFilePrivate::Section& section, size_t index) {
+        section.renameFile(index, newFileName, sorted, d_->fileNameCompare);
+    });
+}
+
+bool ListFile::removeSourceFile(std::string_view target, std::string_view fileName)
+{
+    const bool sorted = d_->sortSectionPolicy == SortSectionPolicy::Sort;
+    return d_->editFile(target, fileName, [&](ListFilePrivate::Section& section, size_t index) {
+        section.removeFile(index, sorted, d_->fileNameCompare);
+    });
+}
+
+size_t ListFile::editSourceFiles(std::string_view target, const std::function<bool(std::string& fileName)>& edit,
+                                 std::vector<std::string>* changedTargets)
+{
+    std::vector<size_t> indices;
+    if (target.empty())
+    {
+        indices.reserve(d_->sourcesFunctions.size());
+        for (size_t i = 0; i < d_->sourcesFunctions.size(); ++i)
+        {
+            indices.push_back(i);
+        }
+    }
+    else if (const auto pos = d_->content->sourcesFunctionsIndex.find(target);
+             pos != d_->content->sourcesFunctionsIndex.end())
+    {
+        indices = pos->second;
+    }
+
+    const bool sorted = d_->sortSectionPolicy == SortSectionPolicy::Sort;
+    size_t changes = 0;
+
+    for (size_t idx : indices)
+    {
+        size_t functionChanges = 0;
+
+        const auto& sections = d_->function(idx).sections;
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            // the new file list is only built once something changes
+            const auto& fileNames = sections[i].fileNames;
+            std::vector<ListFilePrivate::Argument> output;
+            size_t sectionChanges = 0;
+            size_t renames = 0;
+
+            for (auto it = fileNames.begin(); it != fileNames.end(); ++it)
+            {
+                const auto& argument = *it;
+                std::string fileName = argument.value;
+                const bool keep = edit(fileName);
+
+                if (keep && fileName == argument.value)
+                {
+                    if (sectionChanges > 0)
+                        output.push_back(argument);
+                    continue;
+                }
+
+                if (sectionChanges++ == 0)
+                {
+                    output.reserve(fileNames.size());
+                    output.assign(fileNames.begin(), it);
+                }
+
+                if (keep)
+                {
+                    auto newArgument = argument;
+                    newArgument.quoted = newArgument.quoted || needsQuotation(fileName);
+                    newArgument.text = argumentText(fileName, newArgument.quoted);
+                    newArgument.value = std::move(fileName);
+                    output.push_back(std::move(newArgument));
+                    ++renames;
+                }
+            }
+
+            if (sectionChanges == 0)
+                continue;
+
+            auto& section = d_->detach(idx).sections[i];
+            section.fileNames.assign(std::move(output));
+            // renames can move files anywhere, so they need a full sort
+            if (renames > 0)
+                section.sorted = false;
+            if (sorted)
+                section.sortFileNames(d_->fileNameCompare);
+
+            functionChanges += sectionChanges;
+        }
+
+        if (functionChanges == 0)
+            continue;
+
+        auto& function = d_->detach(idx);
+        function.dirty = true;
+        if (changedTargets &&
+                std::find(changedTargets->begin(), changedTargets->end(), function.target) == changedTargets->end())
+            changedTargets->push_back(function.target);
+        changes += functionChanges;
+    }
+
+    return changes;
+}
+
+std::vector<std::string> ListFile::targets() const
+{
+    const auto& index = d_->content->sourcesFunctionsIndex;
+
+    std::vector<std::string> output;
+    output.reserve(index.size());
+    for (const auto& entry : index)
+    {
+        output.push_back(entry.first);
+    }
+    return output;
+}
+
+std::vector<std::string> ListFile::sourceFiles(std::string_view target, std::string_view sectionName) const
+{
+    const auto pos = d_->content->sourcesFunctionsIndex.find(target);
+    if (pos == d_->content->sourcesFunctionsIndex.end())
+        return {};
+
+    std::vector<std::string> output;
+    for (size_t idx : pos->second)
+    {
+        for (const auto& section : d_->function(idx).sections)
+        {
+            if (!sectionName.empty() && !equalsIgnoreCase(section.nameArgument.value, sectionName))
+                continue;
+
+            for (const auto& fileName : section.fileNames)
+            {
+                output.push_back(fileName.value);
+            }
+        }
+    }
+    return output;
+}
+
+std::vector<SourcesBlock> ListFile::sourcesBlocks() const
+{
+    std::vector<SourcesBlock> output;
+    output.reserve(d_->sourcesFunctions.size());
+    for (const auto& function : d_->sourcesFunctions)
+    {
+        SourcesBlock block{function->name, function->target, function->startLine, function->endLine, {}};
+        block.sections.reserve(function->sections.size());
+        for (const auto& section : function->sections)
+        {
+            SourcesSection sourcesSection{section.nameArgument.value, {}};
+            sourcesSection.fileNames.reserve(section.fileNames.size());
+            for (const auto& fileName : section.fileNames)
+            {
+                sourcesSection.fileNames.push_back(fileName.value);
+            }
+            block.sections.push_back(std::move(sourcesSection));
+        }
+        output.push_back(std::move(block));
+    }
+    return output;
+}
+
+const std::vector<std::string>& ListFile::subdirectories() const
+{
+    return d_->content->subdirectories;
+}
+
+std::string ListFile::write() const
+{
+    std::string output;
+    write(output);
+    return output;
+}
+
+void ListFile::markSaved(std::string content)
+{
+    CMLE_CORE_TRACE_SCOPE("markSaved");
+
+    auto owner = std::make_shared<const std::string>(std::move(content));
+    auto saved = std::make_shared<ListFilePrivate::Content>(*d_->content);
+    saved->text = *owner;
+    saved->owner = std::move(owner);
+
+    // every function moves by the size and line count differences of the edited functions in front of it
+    ptrdiff_t offsetShift = 0;
+    int lineShift = 0;
+    for (size_t i = 0; i < d_->sourcesFunctions.size(); ++i)
+    {
+        const auto& function = d_->function(i);
+        if (!function.dirty && offsetShift == 0 && lineShift == 0)
+            continue;
+
+        size_t size = 0;
+        int lines = 0;
+        if (function.dirty)
+        {
+            auto sink = [&size, &lines](std::string_view piece) {
+                size += piece.size();
+                lines += static_cast<int>(std::count(piece.begin(), piece.end(), '\n'));
+            };
+            function.serialize(sink);
+        }
+
+        auto& moved = d_->detach(i);
+        const auto oldSize = static_cast<ptrdiff_t>(moved.end - moved.begin);
+        const int oldLines = moved.endLine - moved.startLine;
+
+        moved.begin = static_cast<size_t>(static_cast<ptrdiff_t>(moved.begin) + offsetShift);
+        moved.startLine += lineShift;
+        if (moved.dirty)
+        {
+            offsetShift += static_cast<ptrdiff_t>(size) - oldSize;
+            lineShift += lines - oldLines;
+            moved.dirty = false;
+        }
+        moved.end = static_cast<size_t>(static_cast<ptrdiff_t>(moved.end) + offsetShift);
+        moved.endLine += lineShift;
+    }
+
+    d_->content = std::move(saved);
+}
+
+size_t ListFile::size() const
+{
+    size_t output = 0;
+    auto sink = [&output](std::string_view piece) { output += piece.size(); };
+    d_->serialize(sink);
+    return output;
+}
+
+void ListFile::write(std::string& output) const
+{
+    CMLE_CORE_TRACE_SCOPE("write");
+
+    // measured first, so the output grows once
+    const size_t size = this->size();
+    output.reserve(output.size() + size);
+
+    auto sink = [&output](std::string_view piece) { output.append(piece); };
+    d_->serialize(sink);
+
+    trace::counter("bytesWritten", static_cast<int64_t>(size));
+}
+
+void ListFile::write(char* output) const
+{
+    CMLE_CORE_TRACE_SCOPE("write");
+
+    char* const start = output;
+    auto sink = [&output](std::string_view piece) {
+        std::memcpy(output, piece.data(), piece.size());
+        output += piece.size();
+    };
+    d_->serialize(sink);
+
+    trace::counter("bytesWritten", output - start);
+}
+
+} // namespace cmle::core
@@ -0,0 +1,42 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "include/cmle/core/Trace.h"
+
+#include <atomic>
+
+namespace cmle::core::trace {
+
+namespace {
+
+std::atomic<const Hooks*> installedHooks{nullptr};
+
+} // namespace
+
+void setHooks(const Hooks* hooks)
+{
+    installedHooks.store(hooks);
+}
+
+void counter(const char* name, int64_t value)
+{
+    if (const auto* hooks = installedHooks.load(std::memory_order_acquire))
+        hooks->counter(name, value);
+}
+
+Scope::Scope(const char* name) :
+    hooks_{installedHooks.load(std::memory_order_acquire)},
+    name_{name},
+    start_{hooks_ ? hooks_->begin() : -1}
+{
+}
+
+Scope::~Scope()
+{
+    if (start_ < 0)
+        return;
+
+    hooks_->end(name_, start_);
+}
+
+} // namespace cmle::core::trace
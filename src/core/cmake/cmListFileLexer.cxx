@@ -785,7 +785,7 @@ struct cmListFileLexer_s
   size_t cr;
   char* string_buffer;
   char* string_position;
-  int string_left;
+  size_t string_left;
   yyscan_t scanner;
 };
 
@@ -793,6 +793,11 @@ static void cmListFileLexerSetToken(cmListFileLexer* lexer, const char* text,
                                     int length);
 static void cmListFileLexerAppend(cmListFileLexer* lexer, const char* text,
                                   int length);
+static const char* cmListFileLexerFindBracketEnd(cmListFileLexer* lexer,
+                                                 const char* pos,
+                                                 const char* end);
+static int cmListFileLexerScanBracket(cmListFileLexer* lexer,
+                                      yyscan_t yyscanner);
 static int cmListFileLexerInput(cmListFileLexer* lexer, char* buffer,
                                 size_t bufferSize);
 static void cmListFileLexerInit(cmListFileLexer* lexer);
@@ -1159,6 +1164,9 @@ YY_RULE_SETUP
   } else {
     lexer->column += yyleng;
   }
+  if (cmListFileLexerScanBracket(lexer, yyscanner)) {
+    return 1;
+  }
   BEGIN(BRACKET);
 }
 	YY_BREAK
@@ -2587,12 +2595,17 @@ static void cmListFileLexerAppend(cmListFileLexer* lexer, const char* text,
   /* If the appended text will fit in the buffer, do not reallocate.  */
   newSize = lexer->token.length + length + 1;
   if (lexer->token.text && newSize <= lexer->size) {
-    strcpy(lexer->token.text + lexer->token.length, text);
+    memcpy(lexer->token.text + lexer->token.length, text, length);
     lexer->token.length += length;
+    lexer->token.text[lexer->token.length] = 0;
     return;
   }
 
-  /* We need to extend the buffer.  */
+  /* We need to extend the buffer.  Grow geometrically, tokens spanning many
+     lines are built from many fragments.  */
+  if (newSize < 2 * lexer->size) {
+    newSize = 2 * lexer->size;
+  }
   temp = (char *)malloc(newSize);
   if (lexer->token.text) {
     memcpy(temp, lexer->token.text, lexer->token.length);
@@ -2605,6 +2618,88 @@ static void cmListFileLexerAppend(cmListFileLexer* lexer, const char* text,
   lexer->size = newSize;
 }
 
+/*--------------------------------------------------------------------------*/
+/* Returns the closing bracket ] followed by bracket-1 = and ] in
+   [pos, end), 0 if there is none.  */
+static const char* cmListFileLexerFindBracketEnd(cmListFileLexer* lexer,
+                                                 const char* pos,
+                                                 const char* end)
+{
+  int i;
+  for (; pos + lexer->bracket < end; ++pos) {
+    pos = (const char*)memchr(pos, ']', (size_t)(end - lexer->bracket - pos));
+    if (!pos) {
+      return 0;
+    }
+    for (i = 1; i < lexer->bracket && pos[i] == '='; ++i) {
+    }
+    if (i == lexer->bracket && pos[i] == ']') {
+      return pos;
+    }
+  }
+  return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Fast path for bracket arguments and comments: look up the closing bracket
+   in the input and take the whole content as one token, instead of matching
+   it line by line.  String input is searched beyond the flex buffer up to
+   its end.  Returns 0 if the closing bracket was not found, the BRACKET rules
+   handle the content then.  */
+static int cmListFileLexerScanBracket(cmListFileLexer* lexer,
+                                      yyscan_t yyscanner)
+{
+  struct yyguts_t* yyg = (struct yyguts_t*)yyscanner;
+  char* start = yyg->yy_c_buf_p;
+  char* end = YY_CURRENT_BUFFER_LVALUE->yy_ch_buf + yyg->yy_n_chars;
+  const char* content = start;
+  const char* close;
+  const char* pos;
+  const char* newline;
+  int inString = 0;
+
+  /* Restore the character yytext was terminated with.  */
+  *start = yyg->yy_hold_char;
+
+  close = cmListFileLexerFindBracketEnd(lexer, start, end);
+  if (!close && lexer->string_buffer) {
+    /* The flex buffer ends with a verbatim copy of the string input read so
+       far, continue the search in the string where the content starts.  */
+    content = lexer->string_position - (end - start);
+    close = cmListFileLexerFindBracketEnd(
+      lexer, content, lexer->string_position + lexer->string_left);
+    inString = 1;
+  }
+
+  if (!close || memchr(content, 0, (size_t)(close - content))) {
+    return 0;
+  }
+
+  cmListFileLexerAppend(lexer, content, (int)(close - content));
+
+  for (pos = content;
+       (newline = (const char*)memchr(pos, '\n', (size_t)(close - pos)));
+       pos = newline + 1) {
+    ++lexer->line;
+    lexer->column = 1;
+  }
+  lexer->column += (int)(close - pos) + lexer->bracket + 1;
+
+  /* Continue scanning after the closing bracket.  */
+  if (inString) {
+    /* Skip the string input up to it and refill the flex buffer from
+       there.  */
+    pos = close + lexer->bracket + 1;
+    lexer->string_left -= (size_t)(pos - lexer->string_position);
+    lexer->string_position = (char*)pos;
+    yy_flush_buffer(YY_CURRENT_BUFFER, yyscanner);
+  } else {
+    yyg->yy_c_buf_p = (char*)close + lexer->bracket + 1;
+    yyg->yy_hold_char = *yyg->yy_c_buf_p;
+  }
+  return 1;
+}
+
 /*--------------------------------------------------------------------------*/
 static int cmListFileLexerInput(cmListFileLexer* lexer, char* buffer,
                                 size_t bufferSize)
@@ -2639,14 +2734,14 @@ static int cmListFileLexerInput(cmListFileLexer* lexer, char* buffer,
       lexer->cr = cr;
       return n;
     } else if (lexer->string_left) {
-      int length = lexer->string_left;
-      if ((int)bufferSize < length) {
-        length = (int)bufferSize;
+      size_t length = lexer->string_left;
+      if (bufferSize < length) {
+        length = bufferSize;
       }
       memcpy(buffer, lexer->string_position, length);
       lexer->string_position += length;
       lexer->string_left -= length;
-      return length;
+      return (int)length;
     }
   }
   return 0;
@@ -2754,7 +2849,7 @@ int cmListFileLexer_SetFileName(cmListFileLexer* lexer, const char* name,
 }
 
 /*--------------------------------------------------------------------------*/
-int cmListFileLexer_SetString(cmListFileLexer* lexer, const char* text, int length)
+int cmListFileLexer_SetString(cmListFileLexer* lexer, const char* text, size_t length)
 {
   int result = 1;
   cmListFileLexerDestroy(lexer);
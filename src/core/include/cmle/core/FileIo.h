@@ -0,0 +1,20 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// File access of the tools built on the core without Qt, cmle::Transaction does the same with QSaveFile.
+namespace cmle::core {
+
+// Reads the whole file into content. Fails for files which cannot be opened or read, including directories.
+bool readFile(const std::string& path, std::string& content);
+
+// Replaces the file with content, so it is never left half written. The content is written to a new temporary file
+// with a unique name in the same directory, synced to disk and renamed over path. The temporary file gets the
+// permissions of the replaced file. Returns false if any step fails, the temporary file is removed then.
+bool writeFileAtomically(const std::string& path, std::string_view content);
+
+} // namespace cmle::core
@@ -0,0 +1,114 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cmle::core {
+
+enum class SortSectionPolicy
+{
+    NoSort,
+    Sort
+};
+
+struct SourcesSection
+{
+    std::string name;
+    std::vector<std::string> fileNames;
+};
+
+// A function defining sources of a target (e.g. add_library() or target_sources()). The lines refer to the original
+// file content.
+struct SourcesBlock
+{
+    // lower case
+    std::string functionName;
+    std::string target;
+    int startLine;
+    int endLine;
+    std::vector<SourcesSection> sections;
+};
+
+// Orders two file names like strcmp(), a negative result sorts lhs first
+using FileNameCompare = int (*)(std::string_view lhs, std::string_view rhs);
+
+class ListFilePrivate;
+
+// Parse/edit/write layer of CMakeLists files, written with the standard library only. It works on the bytes of the
+// file, file names are passed in the encoding of the file (UTF-8 for the command line tools and the C API).
+// cmle::CMakeListsFile adapts it to Qt, command line tools and the C API use it directly. Functions which are not
+// edited are written back byte for byte, edited ones keep the original text of all untouched arguments including
+// comments.
+//
+// Copies share the parsed content, the functions and the file lists of their sections, which are split into chunks of
+// about 64 file names. An edit copies the function it changes without its file lists, the chunk pointers of the edited
+// section and the one chunk it changes. A copy can be read from other threads while the original is edited.
+class ListFile
+{
+public:
+    explicit ListFile(std::string content);
+    // Reads content in place instead of taking a copy, owner has to keep it valid and unchanged. Copies of the file
+    // share owner, it is released with the last of them.
+    ListFile(std::string_view content, std::shared_ptr<const void> owner);
+    ListFile(const ListFile& other);
+    ListFile& operator=(const ListFile& other);
+    ListFile(ListFile&& other) noexcept;
+    ListFile& operator=(ListFile&& other) noexcept;
+    ~ListFile();
+
+    bool isLoaded() const;
+    // Line where parsing failed, 0 if the file was loaded
+    int errorLine() const;
+
+    void setSortSectionPolicy(SortSectionPolicy sortSectionPolicy);
+    SortSectionPolicy sortSectionPolicy() const;
+
+    // Order of the file names within a sorted section, after the ones with a directory. Without it file names are
+    // compared ignoring the case of ASCII letters. Copies of the file keep the order.
+    void setFileNameCompare(FileNameCompare compare);
+
+    bool hasChangedBlocks() const;
+    bool hasTarget(std::string_view target) const;
+
+    // Only sections named sectionName (ignoring case) are chosen if it is not empty
+    bool addSourceFile(std::string_view target, std::string_view fileName, std::string_view sectionName = {});
+    bool renameSourceFile(std::string_view target, std::string_view oldFileName, std::string_view newFileName);
+    bool removeSourceFile(std::string_view target, std::string_view fileName);
+
+    // Calls edit for every file name of target, or of all targets if target is empty. edit may change the file name or
+    // return false to remove the file. Every changed section is sorted once (with SortSectionPolicy::Sort). Returns the
+    // number of changed files, the changed targets are appended to changedTargets if given.
+    size_t editSourceFiles(std::string_view target, const std::function<bool(std::string& fileName)>& edit,
+                           std::vector<std::string>* changedTargets = nullptr);
+
+    // sorted by name
+    std::vector<std::string> targets() const;
+    // All sections if sectionName is empty
+    std::vector<std::string> sourceFiles(std::string_view target, std::string_view sectionName = {}) const;
+    std::vector<SourcesBlock> sourcesBlocks() const;
+    const std::vector<std::string>& subdirectories() const;
+
+    // Number of bytes write() produces
+    size_t size() const;
+    std::string write() const;
+    // Appends the content to output, which can be reused between files. Reserves the exact size up front, so writing
+    // into an empty string allocates once.
+    void write(std::string& output) const;
+    // Writes exactly size() bytes to output, e.g. into a buffer allocated by the caller
+    void write(char* output) const;
+
+    // Makes content, which has to be the output of write(), the unchanged state of the file without parsing it again,
+    // e.g. after saving it. The functions are moved to their place in content and marked unchanged.
+    void markSaved(std::string content);
+
+private:
+    std::unique_ptr<ListFilePrivate> d_;
+};
+
+} // namespace cmle::core
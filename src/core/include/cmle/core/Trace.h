@@ -0,0 +1,44 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+
+// Phase level instrumentation of the core. It records nothing by itself: cmle::trace installs hooks which forward to
+// its recorder, so the core does not depend on Qt. Without hooks a scope costs one atomic load.
+namespace cmle::core::trace {
+
+struct Hooks
+{
+    // returns the start time of a scope, or -1 if tracing is disabled
+    int64_t (*begin)();
+    void (*end)(const char* name, int64_t start);
+    void (*counter)(const char* name, int64_t value);
+};
+
+// hooks has to stay valid until it is replaced, nullptr removes them
+void setHooks(const Hooks* hooks);
+
+// Records the value of a counter, name has to be a string literal.
+void counter(const char* name, int64_t value);
+
+// Records the time between construction and destruction, name has to be a string literal.
+class Scope
+{
+public:
+    explicit Scope(const char* name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const Hooks* hooks_;
+    const char* name_;
+    int64_t start_;
+};
+
+} // namespace cmle::core::trace
+
+#define CMLE_CORE_TRACE_SCOPE(name) const ::cmle::core::trace::Scope cmleCoreTraceScope{name}
@@ -0,0 +1,248 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+// Qt free command line tool for the add/del/ren/targets commands of cmle, for scripts calling it once per edit where
+// the startup of the Qt runtime dominates.
+
+#include <cmle/core/FileIo.h>
+#include <cmle/core/ListFile.h>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    std::string command;
+    std::string target;
+    std::string cmlFile;
+    std::vector<std::string> fileNames;
+    bool inPlace = false;
+    bool sort = false;
+};
+
+const char* const kUsage =
+        "Usage: cmle-lite (--add | --del | --ren | --targets) [-t <target>] [-s] [-i] -f <file> <file-names>...\n"
+        "\n"
+        "  --add              Add file names to the target.\n"
+        "  --del              Delete file names from the target.\n"
+        "  --ren              Rename a file name of the target.\n"
+        "  --targets          List all targets as JSON.\n"
+        "  -t, --target       The cmake target name for the file operations.\n"
+        "  -f, --file         Path to the CMakeLists.txt file.\n"
+        "  -i, --in-place     Write the result back to the CMakeLists.txt file instead of stdout.\n"
+        "  -s, --sort         Sort section after adding/removing/renaming file.\n";
+
+bool parseCommandLine(int argc, char* argv[], Options& options, std::string& errorMessage)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        auto value = [&](std::string& output) {
+            if (i + 1 >= argc)
+            {
+                errorMessage = "Missing value for " + arg;
+                return false;
+            }
+            output = argv[++i];
+            return true;
+        };
+
+        if (arg == "--add" || arg == "--del" || arg == "--ren" || arg == "--targets")
+        {
+            if (!options.command.empty())
+            {
+                errorMessage = "Only one command can be specified";
+                return false;
+            }
+            options.command = arg.substr(2);
+        }
+        else if (arg == "-t" || arg == "--target")
+        {
+            if (!value(options.target))
+                return false;
+        }
+        else if (arg == "-f" || arg == "--file")
+        {
+            if (!value(options.cmlFile))
+                return false;
+        }
+        else if (arg == "-i" || arg == "--in-place")
+        {
+            options.inPlace = true;
+        }
+        else if (arg == "-s" || arg == "--sort")
+        {
+            options.sort = true;
+        }
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            errorMessage = "Unknown option " + arg;
+            return false;
+        }
+        else
+        {
+            options.fileNames.push_back(arg);
+        }
+    }
+
+    if (options.command.empty())
+    {
+        errorMessage = "No command specified";
+        return false;
+    }
+
+    if (options.cmlFile.empty())
+    {
+        errorMessage = "No CMakeLists.txt file specified";
+        return false;
+    }
+
+    if (options.command == "targets")
+        return true;
+
+    if (options.target.empty())
+    {
+        errorMessage = "No target specified";
+        return false;
+    }
+
+    if (options.command == "ren" ? options.fileNames.size() != 2 : options.fileNames.empty())
+    {
+        errorMessage = options.command == "ren" ? "Specify a source and a target file name" : "No file names specified";
+        return false;
+    }
+
+    return true;
+}
+
+// other control characters are not allowed in JSON strings, they are written as \u00XX
+void writeJsonString(std::ostream& output, const std::string& string)
+{
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+
+    output << '"';
+    for (char ch : string)
+    {
+        switch (ch)
+        {
+            case '"': output << "\\\""; break;
+            case '\\': output << "\\\\"; break;
+            case '\n': output << "\\n"; break;
+            case '\r': output << "\\r"; break;
+            case '\t': output << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20)
+                    output << "\\u00" << kHexDigits[(ch >> 4) & 0xf] << kHexDigits[ch & 0xf];
+                else
+                    output << ch;
+                break;
+        }
+    }
+    output << '"';
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::ios::sync_with_stdio(false);
+
+    Options options;
+    std::string errorMessage;
+    if (!parseCommandLine(argc, argv, options, errorMessage))
+    {
+        std::cerr << errorMessage << "\n\n" << kUsage;
+        return 1;
+    }
+
+    std::error_code error;
+    if (!std::filesystem::exists(options.cmlFile, error))
+    {
+        std::cerr << "CMakeLists file does not exists" << std::endl;
+        return 1;
+    }
+
+    std::string content;
+    if (!cmle::core::readFile(options.cmlFile, content))
+    {
+        std::cerr << "Could not read CMakeLists file" << std::endl;
+        return 1;
+    }
+
+    cmle::core::ListFile file{std::move(content)};
+    if (!file.isLoaded())
+    {
+        std::cerr << "Could not parse CMakeLists file" << std::endl;
+        return 1;
+    }
+
+    if (options.command == "targets")
+    {
+        const auto targets = file.targets();
+        std::cout << '[';
+        for (size_t i = 0; i < targets.size(); ++i)
+        {
+            if (i > 0)
+                std::cout << ',';
+            writeJsonString(std::cout, targets[i]);
+        }
+        std::cout << ']' << std::endl;
+        return 0;
+    }
+
+    file.setSortSectionPolicy(options.sort ? cmle::core::SortSectionPolicy::Sort
+                                           : cmle::core::SortSectionPolicy::NoSort);
+
+    std::vector<std::string> failed;
+    if (options.command == "add")
+    {
+        for (const auto& fileName : options.fileNames)
+        {
+            if (!file.addSourceFile(options.target, fileName))
+                failed.push_back(fileName);
+        }
+    }
+    else if (options.command == "del")
+    {
+        for (const auto& fileName : options.fileNames)
+        {
+            if (!file.removeSourceFile(options.target, fileName))
+                failed.push_back(fileName);
+        }
+    }
+    else if (!file.renameSourceFile(options.target, options.fileNames[0], options.fileNames[1]))
+    {
+        failed.push_back(options.fileNames[0]);
+    }
+
+    for (const auto& fileName : failed)
+    {
+        std::cerr << "Command " << options.command << " failed for target " << options.target << ": " << fileName
+                  << std::endl;
+    }
+
+    const auto output = file.write();
+
+    if (options.inPlace)
+    {
+        if (!file.hasChangedBlocks())
+            return failed.empty() ? 0 : 1;
+
+        if (!cmle::core::writeFileAtomically(options.cmlFile, output))
+        {
+            std::cerr << "Could not write CMakeLists file" << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+        std::cout.flush();
+    }
+
+    return failed.empty() ? 0 : 1;
+}
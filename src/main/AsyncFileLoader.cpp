@@ -0,0 +1,326 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "include/cmle/AsyncFileLoader.h"
+
+#include "include/cmle/StandardFileBuffer.h"
+#include <QFile>
+#include <QLoggingCategory>
+#include <QThreadPool>
+#include <algorithm>
+#include <vector>
+
+#ifdef CMLE_HAVE_IO_URING
+#include <cerrno>
+#include <fcntl.h>
+#include <liburing.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cmle {
+
+namespace {
+
+const QLoggingCategory CMAKE{"CMAKE"};
+
+#ifdef CMLE_HAVE_IO_URING
+// Linux never transfers more than this in a single read
+constexpr qsizetype kMaxReadSize = 0x7ffff000;
+
+struct ReadRequest
+{
+    qsizetype index{-1};
+    int fd{-1};
+    QByteArray content{};
+    qsizetype readBytes{0};
+    // a read into content is in flight
+    bool reading{false};
+};
+#endif
+
+} // namespace
+
+// *********************************************************************************************************************
+
+class AsyncFileLoaderPrivate
+{
+public:
+    AsyncFileLoaderPrivate(AsyncFileLoader* q) :
+        q_ptr{q}
+    {
+    }
+
+    void dispatch(const QString& fileName, QByteArray content, bool success, const AsyncFileLoader::Handler& handler);
+    void dispatchLoad(const QString& fileName, const AsyncFileLoader::Handler& handler);
+
+#ifdef CMLE_HAVE_IO_URING
+    bool loadWithIoUring(const QStringList& fileNames, const AsyncFileLoader::Handler& handler);
+#endif
+
+    QThreadPool threadPool{};
+    int maxConcurrentReads{64};
+
+private:
+    AsyncFileLoader* q_ptr;
+    Q_DECLARE_PUBLIC(AsyncFileLoader)
+};
+
+void AsyncFileLoaderPrivate::dispatch(const QString& fileName, QByteArray content, bool success,
+                                      const AsyncFileLoader::Handler& handler)
+{
+    threadPool.start([fileName, content = std::move(content), success, &handler]() {
+        handler(fileName, content, success);
+    });
+}
+
+void AsyncFileLoaderPrivate::dispatchLoad(const QString& fileName, const AsyncFileLoader::Handler& handler)
+{
+    threadPool.start([fileName, &handler]() {
+        StandardFileBuffer buffer{fileName};
+        const bool success = buffer.load();
+        handler(fileName, buffer.content(), success);
+    });
+}
+
+#ifdef CMLE_HAVE_IO_URING
+bool AsyncFileLoaderPrivate::loadWithIoUring(const QStringList& fileNames, const AsyncFileLoader::Handler& handler)
+{
+    io_uring ring{};
+    if (io_uring_queue_init(static_cast<unsigned>(maxConcurrentReads), &ring, 0) < 0)
+        return false;
+
+    std::vector<ReadRequest> requests(static_cast<size_t>(fileNames.size()));
+    qsizetype nextIndex = 0;
+    int inFlight = 0;
+
+    auto finishRequest = [this, &fileNames, &handler](ReadRequest& request, bool success) {
+        // open() may have failed already
+        if (request.fd >= 0)
+            ::close(request.fd);
+        request.fd = -1;
+        request.content.resize(success ? request.readBytes : 0);
+        dispatch(fileNames[request.index], std::move(request.content), success, handler);
+    };
+
+    auto prepareRead = [&ring, &inFlight](ReadRequest& request) {
+        // there is always a free entry, the queue is as deep as the number of reads in flight
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        const auto length = std::min(request.content.size() - request.readBytes, kMaxReadSize);
+        io_uring_prep_read(sqe, request.fd, request.content.data() + request.readBytes, static_cast<unsigned>(length),
+                           static_cast<__u64>(request.readBytes));
+        io_uring_sqe_set_data(sqe, &request);
+        request.reading = true;
+        ++inFlight;
+    };
+
+    auto waitForCompletion = [&ring](io_uring_cqe*& cqe) {
+        int result{};
+        do
+        {
+            result = io_uring_wait_cqe(&ring, &cqe);
+        }
+        while (result == -EINTR);
+        return result;
+    };
+
+    bool waitFailed = false;
+
+    while (nextIndex < fileNames.size() || inFlight > 0)
+    {
+        while (nextIndex < fileNames.size() && inFlight < maxConcurrentReads)
+        {
+            auto& request = requests[static_cast<size_t>(nextIndex)];
+            request.index = nextIndex++;
+
+            const auto& fileName = fileNames[request.index];
+
+            request.fd = ::open(QFile::encodeName(fileName).constData(), O_RDONLY | O_CLOEXEC);
+            struct stat fileStat{};
+            if (request.fd < 0 || ::fstat(request.fd, &fileStat) < 0)
+            {
+                qCCritical(CMAKE) << "Could not open" << fileName << "for reading";
+                finishRequest(request, false);
+                continue;
+            }
+
+            if (!S_ISREG(fileStat.st_mode) || fileStat.st_size == 0)
+            {
+                // size is not known in advance (pipes, /proc files), leave it to the generic implementation
+                if (request.fd >= 0)
+                    ::close(request.fd);
+                request.fd = -1;
+                dispatchLoad(fileName, handler);
+                continue;
+            }
+
+            request.content = QByteArray(static_cast<qsizetype>(fileStat.st_size), Qt::Uninitialized);
+            prepareRead(request);
+        }
+
+        if (inFlight == 0)
+            continue;
+
+        io_uring_submit(&ring);
+
+        io_uring_cqe* cqe{};
+        const int result = waitForCompletion(cqe);
+        if (result < 0)
+        {
+            qCCritical(CMAKE) << "Waiting for io_uring completion failed with error" << -result;
+            waitFailed = true;
+            break;
+        }
+
+        unsigned head{};
+        unsigned completed{};
+        io_uring_for_each_cqe(&ring, head, cqe)
+        {
+            ++completed;
+            --inFlight;
+
+            auto& request = *static_cast<ReadRequest*>(io_uring_cqe_get_data(cqe));
+            request.reading = false;
+
+            if (cqe->res == -EAGAIN || cqe->res == -EINTR)
+            {
+                prepareRead(request);
+            }
+            else if (cqe->res < 0)
+            {
+                qCCritical(CMAKE) << "Error while reading file" << fileNames[request.index];
+                finishRequest(request, false);
+            }
+            else
+            {
+                request.readBytes += cqe->res;
+
+                // file was truncated meanwhile (res == 0) or is completely read
+                if (cqe->res == 0 || request.readBytes == request.content.size())
+                    finishRequest(request, true);
+                else
+                    prepareRead(request);
+            }
+        }
+        io_uring_cq_advance(&ring, completed);
+    }
+
+    if (waitFailed)
+    {
+        // The reads in flight write into their requests until they complete, so they are cancelled and every
+        // completion is consumed before the ring is closed. Cancelling is best effort, reads of regular files also
+        // complete by themselves.
+        int cancels = 0;
+        for (auto& request : requests)
+        {
+            if (!request.reading)
+                continue;
+
+            io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            if (!sqe)
+            {
+                io_uring_submit(&ring);
+                sqe = io_uring_get_sqe(&ring);
+                if (!sqe)
+                    break;
+            }
+            io_uring_prep_cancel(sqe, &request, 0);
+            io_uring_sqe_set_data(sqe, nullptr);
+            ++cancels;
+        }
+        io_uring_submit(&ring);
+
+        while (inFlight > 0 || cancels > 0)
+        {
+            io_uring_cqe* cqe{};
+            const int result = waitForCompletion(cqe);
+            if (result < 0)
+            {
+                qCCritical(CMAKE) << "Waiting for io_uring completion failed again with error" << -result;
+                break;
+            }
+
+            auto* request = static_cast<ReadRequest*>(io_uring_cqe_get_data(cqe));
+            if (!request)
+            {
+                --cancels;
+            }
+            else
+            {
+                --inFlight;
+                request->reading = false;
+                if (cqe->res > 0)
+                    request->readBytes += cqe->res;
+                // completed reads are kept, partial ones are read again by the thread pool
+                if (cqe->res == 0 || (cqe->res > 0 && request->readBytes == request->content.size()))
+                    finishRequest(*request, true);
+            }
+            io_uring_cqe_seen(&ring, cqe);
+        }
+    }
+
+    io_uring_queue_exit(&ring);
+
+    // only reached with unfinished files if waiting for completions failed, they are loaded by the thread pool
+    for (auto& request : requests)
+    {
+        if (request.reading)
+        {
+            // never completed, the kernel may still write into the buffer so it is never freed
+            static_cast<void>(new QByteArray{std::move(request.content)});
+        }
+        if (request.fd >= 0)
+        {
+            ::close(request.fd);
+            request.fd = -1;
+            dispatchLoad(fileNames[request.index], handler);
+        }
+    }
+    for (; nextIndex < fileNames.size(); ++nextIndex)
+    {
+        dispatchLoad(fileNames[nextIndex], handler);
+    }
+
+    return true;
+}
+#endif
+
+// *********************************************************************************************************************
+
+AsyncFileLoader::AsyncFileLoader() :
+    d_ptr{new AsyncFileLoaderPrivate{this}}
+{
+}
+
+AsyncFileLoader::~AsyncFileLoader() = default;
+
+void AsyncFileLoader::setMaxThreadCount(int maxThreadCount)
+{
+    Q_D(AsyncFileLoader);
+    d->threadPool.setMaxThreadCount(maxThreadCount);
+}
+
+void AsyncFileLoader::setMaxConcurrentReads(int maxConcurrentReads)
+{
+    Q_D(AsyncFileLoader);
+    d->maxConcurrentReads = std::max(maxConcurrentReads, 1);
+}
+
+void AsyncFileLoader::load(const QStringList& fileNames, const Handler& handler)
+{
+    Q_D(AsyncFileLoader);
+
+#ifdef CMLE_HAVE_IO_URING
+    if (!d->loadWithIoUring(fileNames, handler))
+#endif
+    {
+        for (const auto& fileName : fileNames)
+        {
+            d->dispatchLoad(fileName, handler);
+        }
+    }
+
+    d->threadPool.waitForDone();
+}
+
+} // namespace cmle
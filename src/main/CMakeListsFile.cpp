@@ -3,14 +3,13 @@
 
 #include "CMakeListsFile_p.h"
 
-#include "parser/CMakeListsParser.h"
-#include <QFile>
-#include <QFileInfo>
+#include "include/cmle/FileBuffer.h"
+#include "include/cmle/Trace.h"
 #include <QLoggingCategory>
 #include <QMimeDatabase>
 #include <QRegularExpression>
-#include <algorithm>
-#include <iostream>
+#include <QStringDecoder>
+#include <QVarLengthArray>
 
 namespace cmle {
 
@@ -18,791 +17,519 @@ namespace {
 
 const QLoggingCategory CMAKE{"com.va.cmakelistsedit"};
 
- // TODO make this configurable or copy from common separators
-const QString kDefaultSeparator = QStringLiteral("\n    "); // clazy:exclude=non-pod-global-static
-
-class RawDataReader
+// The core works on the bytes of the file, which are in the local 8-bit encoding
+std::string toStdString(const QString& string)
 {
-public:
-    RawDataReader(QByteArray data) :
-        data_(std::move(data))
-    {
-    }
+    const QByteArray bytes = string.toLocal8Bit();
+    return {bytes.constData(), static_cast<size_t>(bytes.size())};
+}
 
-    QByteArray readLine()
-    {
-        QByteArray output;
-        output.reserve(1024);
-        while (!eof())
-        {
-            char ch = data_.at(bytePos_++);
-            output.append(ch);
-            if (ch == '\n')
-            {
-                ++currentLine_;
-                break;
-            }
-        }
-        return output;
-    }
+QString fromStdString(const std::string& string)
+{
+    return QString::fromLocal8Bit(string.data(), static_cast<qsizetype>(string.size()));
+}
 
-    bool eof() const { return bytePos_ >= data_.size(); }
-    int currentLine() const { return currentLine_; }
+// File name order of sorted sections. Sorting compares the file names a lot, so they are decoded on the stack.
+int localeAwareCompare(std::string_view lhs, std::string_view rhs)
+{
+    using Buffer = QVarLengthArray<QChar, 256>;
+    const auto decode = [](std::string_view input, Buffer& output) {
+        QStringDecoder decoder{QStringDecoder::System};
+        output.resize(decoder.requiredSpace(static_cast<qsizetype>(input.size())));
+        const QChar* end = decoder.appendToBuffer(output.data(),
+                                                  QByteArrayView{input.data(), static_cast<qsizetype>(input.size())});
+        return QStringView{output.data(), end - output.data()};
+    };
 
-private:
-    QByteArray data_;
-    int bytePos_{0};
-    int currentLine_{1};
-};
+    Buffer lhsBuffer;
+    Buffer rhsBuffer;
+    return QString::localeAwareCompare(decode(lhs, lhsBuffer), decode(rhs, rhsBuffer));
+}
 
-struct FileNameCompare
+QStringList fromStdStrings(const std::vector<std::string>& strings)
 {
-    inline bool operator()(const parser::CMakeFunctionArgument& lhs, const parser::CMakeFunctionArgument& rhs)
+    QStringList output;
+    output.reserve(static_cast<qsizetype>(strings.size()));
+    for (const auto& string : strings)
     {
-        static const QRegularExpression hasSlashExpr(QStringLiteral("[/\\\\]"));
-        bool lhsHasSlash = lhs.value().contains(hasSlashExpr);
-        bool rhsHasSlash = rhs.value().contains(hasSlashExpr);
-        if (lhsHasSlash && !rhsHasSlash)
-            return true;
-        else if (!lhsHasSlash && rhsHasSlash)
-            return false;
-        return QString::localeAwareCompare(lhs.value(), rhs.value()) < 0;
+        output << fromStdString(string);
     }
-};
+    return output;
+}
 
-bool needsQuotation(const QString& argument)
+core::SortSectionPolicy toCore(SortSectionPolicy sortSectionPolicy)
 {
-    return argument.contains(QLatin1Char(' ')); // TODO find more reasons for quoting
+    return sortSectionPolicy == SortSectionPolicy::Sort ? core::SortSectionPolicy::Sort
+                                                        : core::SortSectionPolicy::NoSort;
 }
 
-auto countRows(const QString& string)
+core::ListFile readFile(const QByteArray& fileBuffer, std::shared_ptr<const void> owner)
 {
-    std::tuple<int, int> output{1, 0};
+    // also creates the trace recorder, which the core reports to
+    CMLE_TRACE_SCOPE("readCMakeFile");
 
-    for (auto i : string)
+    // The core reads the content in place. A heap buffer is shared, only content created with
+    // QByteArray::fromRawData() and not kept alive by its buffer (owner) is copied.
+    std::shared_ptr<const QByteArray> content;
+    if (!owner)
     {
-        if (i == QLatin1Char('\n'))
-        {
-            std::get<0>(output) += 1;
-            std::get<1>(output) = 0;
-        }
-        else
-        {
-            std::get<1>(output) += 1;
-        }
+        content = std::make_shared<const QByteArray>(
+                    fileBuffer.capacity() == 0 ? QByteArray{fileBuffer.constData(), fileBuffer.size()} : fileBuffer);
+        owner = content;
     }
 
+    const QByteArray& data = content ? *content : fileBuffer;
+    core::ListFile output{std::string_view{data.constData(), static_cast<size_t>(data.size())}, std::move(owner)};
+    output.setFileNameCompare(localeAwareCompare);
+    if (!output.isLoaded())
+        qCCritical(CMAKE) << "Error while parsing at line" << output.errorLine();
     return output;
 }
 
-template<typename... T>
-inline bool compareStrings(const QString& string, T... strings)
-{
-    return ((string.compare(QLatin1String(strings), Qt::CaseInsensitive) == 0) || ...);
-}
-
-QString extractPath(const QString& fileName)
-{
-    const QFileInfo fi{fileName};
-    const auto path = fi.path();
-    if (path == QLatin1String("."))
-        return QLatin1String{""};
-    return path;
-}
-
 } // namespace
 
 // *********************************************************************************************************************
 
-CMakeListsFilePrivate::Section::Section()
+CMakeListsFilePrivate::CMakeListsFilePrivate(CMakeListsFile* q, const QByteArray& fileBuffer,
+                                             std::shared_ptr<const void> owner) :
+    q_ptr{q},
+    file{readFile(fileBuffer, std::move(owner))},
+    sortSectionPolicy{SortSectionPolicy::NoSort},
+    undoLimit{0},
+    identity{std::make_shared<const Identity>()}
 {
+    publish();
 }
 
-CMakeListsFilePrivate::Section::Section(parser::CMakeFunctionArgument nameArgument) :
-    nameArgument_{std::move(nameArgument)},
-    name_{nameArgument_.value()}
+void CMakeListsFilePrivate::publish()
 {
+    std::atomic_store(&published, std::make_shared<const CMakeListsFileSnapshotData>(identity, file));
 }
 
-void CMakeListsFilePrivate::Section::finalize()
+std::shared_ptr<const CMakeListsFileSnapshotData> CMakeListsFilePrivate::current() const
 {
-    for (const auto& fileName : fileNames_)
-    {
-        commonPrefixes_.insert(extractPath(fileName.value()));
-    }
+    return std::atomic_load(&published);
 }
 
-void CMakeListsFilePrivate::Section::addFileArgument(parser::CMakeFunctionArgument fileArgument)
+bool CMakeListsFilePrivate::hasTarget(const QString& target) const
 {
-    fileNames_ << std::move(fileArgument);
+    if (file.hasTarget(toStdString(target)))
+        return true;
+
+    qCWarning(CMAKE) << "Target" << target << "not found in CMakeLists file";
+    return false;
 }
 
-void CMakeListsFilePrivate::Section::addFileName(const QString& fileName)
+QString CMakeListsFilePrivate::preferedSectionName(const QString& fileName, const QMimeType& mimeType) const
 {
-    const QString separator = !fileNames_.isEmpty() ? fileNames_.last().separator() : kDefaultSeparator;
+    auto mt = mimeType.isValid() ? mimeType : QMimeDatabase().mimeTypeForFile(fileName);
+    Q_UNUSED(mt)
 
-    fileNames_ << parser::CMakeFunctionArgument{fileName, needsQuotation(fileName), separator};
+    // no section is chosen by type yet, e.g. for the QML files of qt_add_qml_module()
+    return {};
 }
 
-bool CMakeListsFilePrivate::Section::renameFile(const QString& oldFileName, const QString& newFileName)
+std::optional<core::ListFile> CMakeListsFilePrivate::undoState() const
 {
-    for (auto& fileName : fileNames_)
-    {
-        if (fileName == oldFileName)
-        {
-            fileName.setValue(newFileName);
-            return true;
-        }
-    }
-    return false;
+    // A copy shares the functions, so the next edit has to copy the one it changes. Without undo there is nothing to
+    // keep the copy for.
+    if (undoLimit == 0)
+        return std::nullopt;
+    return file;
 }
 
-bool CMakeListsFilePrivate::Section::removeFile(const QString& fileName)
+void CMakeListsFilePrivate::pushUndoState(std::optional<core::ListFile> previousState)
 {
-    for (qsizetype i = 0; i < fileNames_.size(); ++i)
-    {
-        if (fileNames_[i] == fileName)
-        {
-            fileNames_.removeAt(i);
-            return true;
-        }
-    }
-    return false;
-}
+    redoStack.clear();
+    if (!previousState)
+        return;
 
-void CMakeListsFilePrivate::Section::sortFileNames()
-{
-    std::sort(fileNames_.begin(), fileNames_.end(), FileNameCompare());
+    undoStack << std::move(*previousState);
+    trimUndoStack();
 }
 
-// *********************************************************************************************************************
-
-CMakeListsFilePrivate::SourcesFunction::SourcesFunction()
+void CMakeListsFilePrivate::trimUndoStack()
 {
-}
+    if (undoLimit < 0)
+        return;
 
-CMakeListsFilePrivate::SourcesFunction::SourcesFunction(parser::CMakeFunction cmakeFunction, QString target) :
-    cmakeFunction_{std::move(cmakeFunction)},
-    target_{std::move(target)}
-{
+    if (undoStack.size() > undoLimit)
+        undoStack.remove(0, undoStack.size() - undoLimit);
+    // redo steps are only created by undo, so they can only exceed the limit after it was lowered
+    if (redoStack.size() > undoLimit)
+        redoStack.remove(0, redoStack.size() - undoLimit);
 }
 
-void CMakeListsFilePrivate::SourcesFunction::finalize()
+void CMakeListsFilePrivate::setState(core::ListFile state)
 {
-    for (auto it = sections_.begin(); it != sections_.end(); ++it)
-    {
-        it->finalize();
-    }
+    file = std::move(state);
+    // the policy is a setting of this file, not part of the restored state
+    file.setSortSectionPolicy(toCore(sortSectionPolicy));
+    publish();
 }
 
-void CMakeListsFilePrivate::SourcesFunction::setCmakeFunction(parser::CMakeFunction cmakeFunction)
-{
-    cmakeFunction_ = std::move(cmakeFunction);
-}
+// *********************************************************************************************************************
 
-void CMakeListsFilePrivate::SourcesFunction::setTarget(QString target)
+CMakeListsFileSnapshotData::CMakeListsFileSnapshotData(std::shared_ptr<const CMakeListsFilePrivate::Identity> _file,
+                                                       core::ListFile _state) :
+    file{std::move(_file)},
+    state{std::move(_state)}
 {
-    target_ = std::move(target);
 }
 
-void CMakeListsFilePrivate::SourcesFunction::addArgument(parser::CMakeFunctionArgument argument)
+QStringList CMakeListsFileSnapshotData::targetsOfSourceFile(const QString& fileName) const
 {
-    arguments_ << Argument{-1, std::move(argument)};
-}
+    // built on first use, possibly by several readers at once
+    std::call_once(sourceFileTargetsBuilt, [this]() {
+        for (const auto& block : state.sourcesBlocks())
+        {
+            const QString target = fromStdString(block.target);
+            for (const auto& section : block.sections)
+            {
+                for (const auto& sourceFile : section.fileNames)
+                {
+                    auto& targets = sourceFileTargets[fromStdString(sourceFile)];
+                    if (!targets.contains(target))
+                        targets << target;
+                }
+            }
+        }
+    });
 
-CMakeListsFilePrivate::Section* CMakeListsFilePrivate::SourcesFunction::addSection()
-{
-    arguments_ << Argument{sections_.size(), {}};
-    sections_ << Section{};
-    return &sections_.last();
+    return sourceFileTargets.value(fileName);
 }
 
-CMakeListsFilePrivate::Section* CMakeListsFilePrivate::SourcesFunction::addSection(parser::CMakeFunctionArgument argument)
-{
-    arguments_ << Argument{sections_.size(), {}};
-    sections_ << Section{std::move(argument)};
-    return &sections_.last();
-}
+// *********************************************************************************************************************
+
+CMakeListsFile::Snapshot::Snapshot() = default;
 
-void CMakeListsFilePrivate::SourcesFunction::setDefaultInsertSection(QString sectionName)
+CMakeListsFile::Snapshot::Snapshot(const Snapshot& other) = default;
+
+CMakeListsFile::Snapshot& CMakeListsFile::Snapshot::operator=(const Snapshot& other) = default;
+
+CMakeListsFile::Snapshot::~Snapshot() = default;
+
+CMakeListsFile::Snapshot::Snapshot(std::shared_ptr<const CMakeListsFileSnapshotData> data) :
+    d{std::move(data)}
 {
-    defaultInsertSection_ = std::move(sectionName);
 }
 
-void CMakeListsFilePrivate::SourcesFunction::setPreferred(bool preferred)
+bool CMakeListsFile::Snapshot::isNull() const
 {
-    preferred_ = preferred;
+    return !d;
 }
 
-// *********************************************************************************************************************
-
-CMakeListsFilePrivate::CMakeListsFilePrivate(CMakeListsFile* q, const QByteArray& fileBuffer) :
-    q_ptr{q},
-    originalFileContent{fileBuffer},
-    loaded{false},
-    sortSectionPolicy{SortSectionPolicy::NoSort}
+bool CMakeListsFile::Snapshot::hasChangedBlocks() const
 {
-    read();
+    return d && d->state.hasChangedBlocks();
 }
 
-QString CMakeListsFilePrivate::sectionName(const parser::CMakeFunctionArgument& arg)
+QStringList CMakeListsFile::Snapshot::targets() const
 {
-    if (arg.value().compare(QLatin1String("PRIVATE"), Qt::CaseInsensitive) == 0)
-        return QLatin1String("PRIVATE");
-    else if (arg.value().compare(QLatin1String("PUBLIC"), Qt::CaseInsensitive) == 0)
-        return QLatin1String("PUBLIC");
-    else if (arg.value().compare(QLatin1String("INTERFACE"), Qt::CaseInsensitive) == 0)
-        return QLatin1String("INTERFACE");
-    else
-        return {};
+    return d ? fromStdStrings(d->state.targets()) : QStringList{};
 }
 
-parser::CMakeFunctionArgument CMakeListsFilePrivate::sectionTypeArgument(const QString& sectionName)
+QStringList CMakeListsFile::Snapshot::sourceFiles(const QString& target, const QString& sectionName) const
 {
-    if (sectionName.isEmpty())
-        return {};
-    return {sectionName, false, kDefaultSeparator};
+    return d ? fromStdStrings(d->state.sourceFiles(toStdString(target), toStdString(sectionName))) : QStringList{};
 }
 
-bool CMakeListsFilePrivate::read()
+QStringList CMakeListsFile::Snapshot::targetsOfSourceFile(const QString& fileName) const
 {
-    loaded = [this]() {
-        bool error{};
-        auto contents = parser::readCMakeFile(originalFileContent, &error);
-        if (error)
-            return false;
-
-        // TODO read target definition blocks
-
-        if (!readInFunctions(contents))
-            return false;
-
-        return true;
-    }();
-
-    return loaded;
+    return d ? d->targetsOfSourceFile(fileName) : QStringList{};
 }
 
-QByteArray CMakeListsFilePrivate::write()
+QList<CMakeListsFile::SourcesBlock> CMakeListsFile::Snapshot::sourcesBlocks() const
 {
-    RawDataReader reader(originalFileContent);
-    QByteArray line;
-
-    QByteArray output;
+    if (!d)
+        return {};
 
-    for (auto& sourcesFunction : sourcesFunctions)
+    QList<SourcesBlock> output;
+    for (const auto& block : d->state.sourcesBlocks())
     {
-        auto function = [&sourcesFunction]() {
-            if (!sourcesFunction.isDirty())
-                return sourcesFunction.cmakeFunction();
-
-            QList<parser::CMakeFunctionArgument> newArguments;
-            for (const auto& argument : qAsConst(sourcesFunction.arguments()))
-            {
-                if (argument.sectionIndex == -1)
-                {
-                    newArguments << argument.argument;
-                }
-                else
-                {
-                    const auto& section = sourcesFunction.sections()[argument.sectionIndex];
-
-                    if (section.nameArgument())
-                        newArguments << section.nameArgument();
-
-                    for (const auto& fileName : section.fileNames())
-                    {
-                        newArguments << fileName;
-                    }
-                }
-            }
-            parser::CMakeFunction newFunction{sourcesFunction.cmakeFunction()};
-            newFunction.setArguments(newArguments);
-
-            return newFunction;
-        }();
-
-        // advance to source block start line
-        while (!reader.eof() && (reader.currentLine() < function.startLine()))
-        {
-            line = reader.readLine();
-            output.append(line);
-        }
-
-        // advance to source block start column
-        if (function.startColumn() > 1 && !reader.eof())
+        SourcesBlock sourcesBlock{fromStdString(block.functionName), fromStdString(block.target), block.startLine,
+                    block.endLine, {}};
+        for (const auto& section : block.sections)
         {
-            line = reader.readLine();
-            output.append(line.data(), function.startColumn() - 1);
+            sourcesBlock.sections << SourcesSection{fromStdString(section.name), fromStdStrings(section.fileNames)};
         }
-
-        // output actual sources block
-        const auto funcOutput = function.toString();
-        output.append(funcOutput.toLocal8Bit());
-
-        // skip over original source block
-        while (!reader.eof() && (reader.currentLine() <= function.endLine()))
-        {
-            line  = reader.readLine();
-        }
-
-        // output remainder of last original line
-        if (int lineRest = static_cast<int>(line.size()) - function.endColumn(); lineRest > 0)
-        {
-            output.append(line.data() + line.size() - lineRest, lineRest);
-        }
-    }
-
-    // output reamainder of file
-    while (!reader.eof())
-    {
-        line = reader.readLine();
-        output.append(line);
+        output << sourcesBlock;
     }
-
     return output;
 }
 
-void CMakeListsFilePrivate::addFunctionIndex(const QString& target, qsizetype index)
+QStringList CMakeListsFile::Snapshot::subdirectories() const
 {
-    auto pos = sourcesFunctionsIndex.find(target);
-    if (pos == sourcesFunctionsIndex.end())
-        pos = sourcesFunctionsIndex.insert(target, {});
-    pos->append(index);
+    return d ? fromStdStrings(d->state.subdirectories()) : QStringList{};
 }
 
-bool CMakeListsFilePrivate::readInFunctions(const parser::CMakeFileContent& cmakeFileContent)
-{
-    for (const auto& func : cmakeFileContent)
-    {
-        auto function = readFunction(func);
-        if (function.target().isEmpty())
-            continue;
-
-        sourcesFunctions << function;
-
-        addFunctionIndex(function.target(), sourcesFunctions.size() - 1);
-    }
+// *********************************************************************************************************************
 
-    return true;
+CMakeListsFile::CMakeListsFile(const QByteArray& fileBuffer, QObject* parent) :
+    QObject{parent},
+    d_ptr{new CMakeListsFilePrivate{this, fileBuffer, nullptr}}
+{
 }
 
-CMakeListsFilePrivate::SectionSearchResult CMakeListsFilePrivate::findBestInsertSection(
-        const QString& target, const QString& fileName, const QMimeType& mimeType)
+CMakeListsFile::CMakeListsFile(const FileBuffer& fileBuffer, QObject* parent) :
+    QObject{parent},
+    d_ptr{new CMakeListsFilePrivate{this, fileBuffer.content(), fileBuffer.contentOwner()}}
 {
-    // get sources functions for target
-    const auto pos = sourcesFunctionsIndex.find(target);
-    if (pos == sourcesFunctionsIndex.end())
-    {
-        qCWarning(CMAKE) << "Could not find sources function for target" << target;
-        return {};
-    }
-
-    const auto parentPath = extractPath(fileName);
+}
 
-    auto selectBestSection = [this, &parentPath](qsizetype bestScore,
-            SourcesFunction* function, const QString& sectionName)
-    {
-        Section* bestSection{};
+CMakeListsFile::~CMakeListsFile()
+{
+}
 
-        for (auto& section : function->sections())
-        {
-            if (!sectionName.isEmpty() && section.name().compare(sectionName, Qt::CaseInsensitive) != 0)
-                continue;
+void CMakeListsFile::setSortSectionPolicy(SortSectionPolicy sortSectionPolicy)
+{
+    Q_D(CMakeListsFile);
+    d->sortSectionPolicy = sortSectionPolicy;
+    d->file.setSortSectionPolicy(toCore(sortSectionPolicy));
+}
 
-            const auto score = commonPrefixScore(parentPath, section);
+bool CMakeListsFile::isLoaded() const
+{
+    Q_D(const CMakeListsFile);
+    return d->file.isLoaded();
+}
 
-            if (score > bestScore)
-            {
-                bestSection = &section;
-                bestScore = score;
-            }
-        }
+bool CMakeListsFile::hasChangedBlocks() const
+{
+    Q_D(const CMakeListsFile);
+    return d->current()->state.hasChangedBlocks();
+}
 
-        return std::pair{bestScore, bestSection};
-    };
+bool CMakeListsFile::addSourceFile(const QString& target, const QString& fileName, const QMimeType& mimeType)
+{
+    Q_D(CMakeListsFile);
 
-    SourcesFunction* selectedFunction{};
-    Section* selectedSection{};
+    const QString sectionName = d->preferedSectionName(fileName, mimeType);
 
-    // find priority function
-    for (qsizetype idx : *pos)
+    auto previousState = d->undoState();
+    if (!d->file.addSourceFile(toStdString(target), toStdString(fileName), toStdString(sectionName)))
     {
-        if (sourcesFunctions[idx].isPreferred())
-        {
-            selectedFunction = &sourcesFunctions[idx];
-
-            const QString sectionName = preferedSectionName(selectedFunction->cmakeFunction().name(), fileName, mimeType);
-
-            auto [bestScore, bestSection] = selectBestSection(std::numeric_limits<qsizetype>::min(),
-                                                              selectedFunction, sectionName);
-            if (!bestSection)
-            {
-                const auto sn = !sectionName.isEmpty() ? sectionName : selectedFunction->defaultInsertSection();
-
-                selectedSection = selectedFunction->addSection({sn, false, kDefaultSeparator});
-            }
-            else
-            {
-                selectedSection = bestSection;
-            }
-
-            break;
-        }
+        qCWarning(CMAKE) << "Target" << target << "has no suitable source block";
+        return false;
     }
 
-    // find best matching function/section
-    if (!selectedSection)
-    {
-        SourcesFunction* bestFunction{};
-        Section* bestSection{};
-        qsizetype bestSectionScore = std::numeric_limits<qsizetype>::min();
-
-        for (qsizetype idx : *pos)
-        {
-            auto function = &sourcesFunctions[idx];
-
-            const QString sectionName = preferedSectionName(function->cmakeFunction().name(), fileName, mimeType);
+    d->pushUndoState(std::move(previousState));
+    d->publish();
 
-            auto [score, section] = selectBestSection(bestSectionScore, function, sectionName);
+    emit sourceFilesChanged(target);
 
-            if (score > bestSectionScore)
-            {
-                bestFunction = function;
-                bestSection = section;
-                bestSectionScore = score;
-            }
-        }
-
-        if (bestSection)
-        {
-            selectedFunction = bestFunction;
-            selectedSection = bestSection;
-        }
-    }
-
-    // get or create a fallback section
-    if (!selectedSection)
-    {
-        selectedFunction = &sourcesFunctions[pos->first()];
-        selectedSection = selectedFunction->addSection(
-                    {selectedFunction->defaultInsertSection(), false, kDefaultSeparator});
-    }
-
-    return {selectedFunction, selectedSection};
+    return true;
 }
 
-CMakeListsFilePrivate::SourcesFunction CMakeListsFilePrivate::readTargetSourcesFunction(const parser::CMakeFunction& function)
+bool CMakeListsFile::renameSourceFile(const QString& target, const QString& oldFileName, const QString& newFileName)
 {
-    SourcesFunction info;
+    Q_D(CMakeListsFile);
 
-    const auto args = function.arguments();
-    auto it = args.begin();
-    if (it != args.cend())
-    {
-        info.setCmakeFunction(function);
-        info.setTarget(it->value());
-        info.addArgument(*it);
+    if (!d->hasTarget(target))
+        return false;
 
-        Section* currentSection{};
+    auto previousState = d->undoState();
+    if (!d->file.renameSourceFile(toStdString(target), toStdString(oldFileName), toStdString(newFileName)))
+        return false;
 
-        for (++it ; it != args.end(); ++it)
-        {
-            if (!it->isQuoted() && (compareStrings(it->value(), "INTERFACE", "PUBLIC", "PRIVATE")))
-            {
-                currentSection = info.addSection({*it});
-            }
-            else if (currentSection)
-            {
-                currentSection->addFileArgument(*it);
-            }
-        }
-    }
+    d->pushUndoState(std::move(previousState));
+    d->publish();
 
-    info.setDefaultInsertSection(QStringLiteral("PRIVATE"));
-    info.finalize();
+    emit sourceFilesChanged(target);
 
-    return info;
+    return true;
 }
 
-CMakeListsFilePrivate::SourcesFunction CMakeListsFilePrivate::readAddTargetFunction(const parser::CMakeFunction& function)
+bool CMakeListsFile::removeSourceFile(const QString& target, const QString& fileName)
 {
-    SourcesFunction info;
-
-    const auto args = function.arguments();
-    auto it = args.begin();
-    if (it != args.cend())
-    {
-        info.setCmakeFunction(function);
-        info.setTarget(it->value());
-        info.addArgument(*it);
-
-        Section* filesSection{};
-
-        // MAYBE: Ignore IMPORTED and ALIAS definitions
-
-        for (++it ; it != args.end(); ++it)
-        {
-            if (!filesSection)
-            {
-                if (!it->isQuoted() &&
-                        compareStrings(it->value(),
-                                       "WIN32", "MACOSX_BUNDLE", "EXCLUDE_FROM_ALL",
-                                       "STATIC", "SHARED", "MODULE", "INTERFACE", "OBJECT",
-                                       "MANUAL_FINALIZATION"))
-                {
-                    info.addArgument(*it);
-                    continue;
-                }
+    Q_D(CMakeListsFile);
 
-                if (!it->isQuoted() &&
-                        compareStrings(it->value(),
-                                       "CLASS_NAME", "OUTPUT_TARGETS"))
-                {
-                    info.addArgument(*it);
-                    ++it;
-                    info.addArgument(*it);
-                    continue;
-                }
+    if (!d->hasTarget(target))
+        return false;
 
-                filesSection = info.addSection();
-            }
+    auto previousState = d->undoState();
+    if (!d->file.removeSourceFile(toStdString(target), toStdString(fileName)))
+        return false;
 
-            if (!it->value().isEmpty())
-                filesSection->addFileArgument(*it);
-        }
-    }
+    d->pushUndoState(std::move(previousState));
+    d->publish();
 
-    info.setDefaultInsertSection(QLatin1String(""));
-    info.finalize();
+    emit sourceFilesChanged(target);
 
-    return info;
+    return true;
 }
 
-CMakeListsFilePrivate::SourcesFunction CMakeListsFilePrivate::readAddQmlTargetFunction(const parser::CMakeFunction& function)
+qsizetype CMakeListsFile::removeSourceFiles(const QString& target, const QRegularExpression& pattern)
 {
-    qCWarning(CMAKE) << "CMake function" << function.name() << "not implemented";
-
-    SourcesFunction info;
-
-    //info.setPreferred(true);
-    //info.finalize();
-
-    return info;
+    return editSourceFiles(target, [&pattern](QString& fileName) {
+        return !pattern.match(fileName).hasMatch();
+    });
 }
 
-CMakeListsFilePrivate::SourcesFunction CMakeListsFilePrivate::readFunction(const parser::CMakeFunction& function)
+qsizetype CMakeListsFile::renameSourceFilePrefix(const QString& target, const QString& oldPrefix,
+                                                 const QString& newPrefix)
 {
-    SourcesFunction info;
-
-    if (compareStrings(function.name(), "target_sources"))
-    {
-        info = readTargetSourcesFunction(function);
-    }
-    else if (compareStrings(function.name(),
-                            "add_executable",
-                            "add_library",
-                            "qt_add_executable",
-                            "qt_add_library",
-                            "qt6_add_executable",
-                            "qt6_add_library"))
-    {
-        info = readAddTargetFunction(function);
-    }
-    else if (compareStrings(function.name(),
-                            "qt_add_qml_module",
-                            "qt6_add_qml_module"))
-    {
-        info = readAddQmlTargetFunction(function);
-    }
-
-    return info;
+    return editSourceFiles(target, [&oldPrefix, &newPrefix](QString& fileName) {
+        if (fileName.startsWith(oldPrefix))
+            fileName.replace(0, oldPrefix.size(), newPrefix);
+        return true;
+    });
 }
 
-qsizetype CMakeListsFilePrivate::commonPrefixLength(const QString& path1, const QString& path2)
+qsizetype CMakeListsFile::replaceSourceFiles(const QString& target, const QRegularExpression& pattern,
+                                             const QString& replacement)
 {
-    qsizetype i = 0;
-    for ( ; i < qMin(path1.length(), path2.length()); ++i)
-    {
-        if (path1.at(i) != path2.at(i))
-            break;
-    }
-    return i;
+    return editSourceFiles(target, [&pattern, &replacement](QString& fileName) {
+        fileName.replace(pattern, replacement);
+        return true;
+    });
 }
 
-qsizetype CMakeListsFilePrivate::commonPrefixScore(const QString& prefix, const Section& section)
+qsizetype CMakeListsFile::editSourceFiles(const QString& target, const std::function<bool(QString& fileName)>& edit)
 {
-    if (section.commonPrefixes().isEmpty())
-        return -1;
+    Q_D(CMakeListsFile);
 
-    qsizetype bestScore = 0;
-    for (const auto& path : section.commonPrefixes())
-    {
-        auto cpl = commonPrefixLength(prefix, path);
+    if (!target.isEmpty() && !d->hasTarget(target))
+        return 0;
 
-        if (cpl == prefix.length() && cpl == path.length()) // perfect match
-            return std::numeric_limits<qsizetype>::max();
+    auto previousState = d->undoState();
 
-        if (cpl > bestScore)
-            bestScore = cpl;
-    }
-    return bestScore;
-}
+    std::vector<std::string> changedTargets;
+    const auto changes = d->file.editSourceFiles(toStdString(target), [&edit](std::string& fileName) {
+        QString string = fromStdString(fileName);
+        const bool keep = edit(string);
+        fileName = toStdString(string);
+        return keep;
+    }, &changedTargets);
 
-QString CMakeListsFilePrivate::preferedSectionName(const QString& functionName, const QString& fileName,
-                                                   const QMimeType& mimeType)
-{
-    auto mt = mimeType.isValid() ? mimeType : QMimeDatabase().mimeTypeForFile(fileName);
-    Q_UNUSED(mt)
+    if (changes == 0)
+        return 0;
 
-    if (compareStrings(functionName,
-                       "qt_add_qml_module",
-                       "qt6_add_qml_module"))
+    d->pushUndoState(std::move(previousState));
+    d->publish();
+
+    for (const auto& changedTarget : changedTargets)
     {
-        Q_UNIMPLEMENTED();
+        emit sourceFilesChanged(fromStdString(changedTarget));
     }
 
-    return {};
+    return static_cast<qsizetype>(changes);
 }
 
-// *********************************************************************************************************************
-
-CMakeListsFile::CMakeListsFile(const QByteArray& fileBuffer, QObject* parent) :
-    QObject{parent},
-    d_ptr{new CMakeListsFilePrivate{this, fileBuffer}}
+CMakeListsFile::Snapshot CMakeListsFile::snapshot() const
 {
+    Q_D(const CMakeListsFile);
+    return Snapshot{d->current()};
 }
 
-CMakeListsFile::~CMakeListsFile()
+void CMakeListsFile::restore(const Snapshot& snapshot)
 {
+    Q_D(CMakeListsFile);
+
+    if (snapshot.isNull() || snapshot.d->file != d->identity)
+    {
+        qCWarning(CMAKE) << "Snapshot does not belong to this CMakeLists file";
+        return;
+    }
+
+    d->pushUndoState(d->undoState());
+    d->setState(snapshot.d->state);
 }
 
-void CMakeListsFile::setSortSectionPolicy(SortSectionPolicy sortSectionPolicy)
+void CMakeListsFile::setUndoLimit(int undoLimit)
 {
     Q_D(CMakeListsFile);
-    d->sortSectionPolicy = sortSectionPolicy;
+    d->undoLimit = undoLimit;
+    d->trimUndoStack();
 }
 
-bool CMakeListsFile::isLoaded() const
+int CMakeListsFile::undoLimit() const
 {
     Q_D(const CMakeListsFile);
-    return d->loaded;
+    return d->undoLimit;
 }
 
-bool CMakeListsFile::hasChangedBlocks() const
+bool CMakeListsFile::canUndo() const
 {
     Q_D(const CMakeListsFile);
-    for (const auto& func : d->sourcesFunctions)
-    {
-        if (func.isDirty())
-            return true;
-    }
-    return false;
+    return !d->undoStack.isEmpty();
 }
 
-bool CMakeListsFile::addSourceFile(const QString& target, const QString& fileName, const QMimeType& mimeType)
+bool CMakeListsFile::canRedo() const
+{
+    Q_D(const CMakeListsFile);
+    return !d->redoStack.isEmpty();
+}
+
+bool CMakeListsFile::undo()
 {
     Q_D(CMakeListsFile);
 
-    auto [function, section] = d->findBestInsertSection(target, fileName, mimeType);
-    if (!section)
-    {
-        qCWarning(CMAKE) << "Target" << target << "has no suitable source block";
+    if (d->undoStack.isEmpty())
         return false;
-    }
-
-    section->addFileName(fileName);
-
-    if (d->sortSectionPolicy == SortSectionPolicy::Sort)
-        section->sortFileNames();
-
-    function->setDirty();
 
+    d->redoStack << d->file;
+    d->setState(d->undoStack.takeLast());
     return true;
 }
 
-bool CMakeListsFile::renameSourceFile(const QString& target, const QString& oldFileName, const QString& newFileName)
+bool CMakeListsFile::redo()
 {
     Q_D(CMakeListsFile);
 
-    if (!d->sourcesFunctionsIndex.contains(target))
-    {
-        qCWarning(CMAKE) << "Target" << target << "not found in CMakeLists file";
+    if (d->redoStack.isEmpty())
         return false;
-    }
-
-    CMakeListsFilePrivate::SourcesFunction* changedFunction{};
-    CMakeListsFilePrivate::Section* changedSection{};
-
-    for (const auto& idx : qAsConst(d->sourcesFunctionsIndex[target]))
-    {
-        auto& function = d->sourcesFunctions[idx];
 
-        for (auto& section : function.sections())
-        {
-            if (section.renameFile(oldFileName, newFileName))
-            {
-                changedFunction = &function;
-                changedSection = &section;
-                break;
-            }
-        }
-    }
-
-    if (changedSection)
-    {
-        if (d->sortSectionPolicy == SortSectionPolicy::Sort)
-            changedSection->sortFileNames();
-
-        changedFunction->setDirty();
-    }
-
-    return changedSection;
+    d->undoStack << d->file;
+    d->setState(d->redoStack.takeLast());
+    return true;
 }
 
-bool CMakeListsFile::removeSourceFile(const QString& target, const QString& fileName)
+void CMakeListsFile::clearUndoStack()
 {
     Q_D(CMakeListsFile);
+    d->undoStack.clear();
+    d->redoStack.clear();
+}
 
-    if (!d->sourcesFunctionsIndex.contains(target))
-    {
-        qCWarning(CMAKE) << "Target" << target << "not found in CMakeLists file";
-        return false;
-    }
-
-    CMakeListsFilePrivate::SourcesFunction* changedFunction{};
-    CMakeListsFilePrivate::Section* changedSection{};
-
-    for (const auto& idx : qAsConst(d->sourcesFunctionsIndex[target]))
-    {
-        auto& function = d->sourcesFunctions[idx];
+QStringList CMakeListsFile::targets() const
+{
+    Q_D(const CMakeListsFile);
+    return Snapshot{d->current()}.targets();
+}
 
-        for (auto& section : function.sections())
-        {
-            if (section.removeFile(fileName))
-            {
-                changedFunction = &function;
-                changedSection = &section;
-                break;
-            }
-        }
-    }
+QStringList CMakeListsFile::sourceFiles(const QString& target, const QString& sectionName) const
+{
+    Q_D(const CMakeListsFile);
+    return Snapshot{d->current()}.sourceFiles(target, sectionName);
+}
 
-    if (changedSection)
-    {
-        if (d->sortSectionPolicy == SortSectionPolicy::Sort)
-            changedSection->sortFileNames();
+QStringList CMakeListsFile::targetsOfSourceFile(const QString& fileName) const
+{
+    Q_D(const CMakeListsFile);
+    return d->current()->targetsOfSourceFile(fileName);
+}
 
-        changedFunction->setDirty();
-    }
+QList<CMakeListsFile::SourcesBlock> CMakeListsFile::sourcesBlocks() const
+{
+    Q_D(const CMakeListsFile);
+    return Snapshot{d->current()}.sourcesBlocks();
+}
 
-    return changedSection;
+QStringList CMakeListsFile::subdirectories() const
+{
+    Q_D(const CMakeListsFile);
+    return Snapshot{d->current()}.subdirectories();
 }
 
 QByteArray CMakeListsFile::write()
 {
     Q_D(CMakeListsFile);
-    return d->write();
+
+    // written in place, without an intermediate std::string
+    QByteArray output{static_cast<qsizetype>(d->file.size()), Qt::Uninitialized};
+    d->file.write(output.data());
+    return output;
 }
 
 } // namespace cmle
@@ -4,131 +4,76 @@
 #pragma once
 
 #include "include/cmle/CMakeListsFile.h"
-#include "parser/CMakeFileContent.h"
-#include <QMap>
-#include <QSet>
+#include <cmle/core/ListFile.h>
+#include <QHash>
+#include <QList>
+#include <memory>
+#include <mutex>
+#include <optional>
 
 namespace cmle {
 
+// Qt adapter of core::ListFile, which parses, edits and writes the file. The adapter converts between UTF-16 and the
+// local 8-bit encoding, sorts file names with QString::localeAwareCompare() and adds snapshots, undo/redo and signals.
+//
+// Copies of a core::ListFile share everything which is not edited, so a snapshot or undo step costs one copy of the
+// function list and the edit copies only the chunk of the section it changes. After every change a new snapshot is
+// published atomically, all queries work on the current snapshot and can run on any thread.
 class CMakeListsFilePrivate
 {
-private:
-    class Section
-    {
-    public:
-        Section();
-        Section(parser::CMakeFunctionArgument nameArgument);
-
-        void finalize();
-
-        const parser::CMakeFunctionArgument& nameArgument() const { return nameArgument_; }
-        const QString& name() const { return name_; }
-        const QList<parser::CMakeFunctionArgument>& fileNames() const { return fileNames_; }
-        const QSet<QString>& commonPrefixes() const { return commonPrefixes_; }
-
-        void addFileArgument(parser::CMakeFunctionArgument fileArgument);
-        void addFileName(const QString& fileName);
-        bool renameFile(const QString& oldFileName, const QString& newFileName);
-        bool removeFile(const QString& fileName);
-
-        void sortFileNames();
-
-    private:
-        parser::CMakeFunctionArgument nameArgument_{};
-        QString name_{};
-        QList<parser::CMakeFunctionArgument> fileNames_{};
-        QSet<QString> commonPrefixes_{};
-    };
-
-    class SourcesFunction
-    {
-    public:
-        struct Argument
-        {
-            qsizetype sectionIndex{-1};
-            parser::CMakeFunctionArgument argument{};
-
-            operator const parser::CMakeFunctionArgument&() const { return argument; }
-        };
-
-    public:
-        SourcesFunction();
-        SourcesFunction(parser::CMakeFunction cmakeFunction, QString target);
-
-        void finalize();
-
-        const parser::CMakeFunction& cmakeFunction() const { return cmakeFunction_; }
-        const QString& target() const { return target_; }
-        const QList<Argument>& arguments() const { return arguments_; }
-        const QList<Section>& sections() const { return sections_; }
-        const QString& defaultInsertSection() const { return defaultInsertSection_; }
-        bool isPreferred() const { return preferred_; }
-
-        QList<Section>& sections() { return sections_; }
-
-        void setDirty(bool _dirty = true) { dirty_ = _dirty; }
-        bool isDirty() const { return dirty_; }
-
-        void setCmakeFunction(parser::CMakeFunction cmakeFunction);
-        void setTarget(QString target);
-        void addArgument(parser::CMakeFunctionArgument argument);
-        Section* addSection();
-        Section* addSection(parser::CMakeFunctionArgument argument);
-        void setDefaultInsertSection(QString sectionName);
-        void setPreferred(bool preferred);
-
-    private:
-        parser::CMakeFunction cmakeFunction_{};
-        QString target_{};
-        QList<Argument> arguments_{};
-        QList<Section> sections_{};
-        QString defaultInsertSection_{};
-        bool preferred_{false};
-        bool dirty_{false};
-    };
-
-    using SectionSearchResult = std::tuple<SourcesFunction*, Section*>;
-
 public:
-    CMakeListsFilePrivate(CMakeListsFile* q, const QByteArray& fileBuffer);
+    // owner keeps the data of fileBuffer alive, see FileBuffer::contentOwner()
+    CMakeListsFilePrivate(CMakeListsFile* q, const QByteArray& fileBuffer, std::shared_ptr<const void> owner);
 
-    static QString sectionName(const parser::CMakeFunctionArgument& arg);
+    void publish();
+    std::shared_ptr<const CMakeListsFileSnapshotData> current() const;
 
-    static parser::CMakeFunctionArgument sectionTypeArgument(const QString& sectionName);
+    bool hasTarget(const QString& target) const;
+    // Section a file of type mimeType is added to, any if empty
+    QString preferedSectionName(const QString& fileName, const QMimeType& mimeType) const;
 
-    QByteArray write();
+    // The file before an edit, if it can be undone
+    std::optional<core::ListFile> undoState() const;
+    // previousState is the state returned by undoState() before the edit
+    void pushUndoState(std::optional<core::ListFile> previousState);
+    void trimUndoStack();
+    void setState(core::ListFile state);
 
-    void addFunctionIndex(const QString& target, qsizetype index);
+private:
+    CMakeListsFile* q_ptr;
+    Q_DECLARE_PUBLIC(CMakeListsFile)
 
-    bool readInFunctions(const parser::CMakeFileContent& cmakeFileContent);
+public:
+    core::ListFile file;
+    SortSectionPolicy sortSectionPolicy;
+    int undoLimit;
+    QList<core::ListFile> undoStack;
+    QList<core::ListFile> redoStack;
 
-    SectionSearchResult findBestInsertSection(const QString& target, const QString& fileName, const QMimeType& mimeType);
+    // Identifies the snapshots of this file. Snapshots keep it alive, so its address cannot be reused by another file
+    // created after this one is destroyed.
+    struct Identity {};
+    const std::shared_ptr<const Identity> identity;
 
 private:
-    bool read();
-
-    SourcesFunction readTargetSourcesFunction(const parser::CMakeFunction& function);
-    SourcesFunction readAddTargetFunction(const parser::CMakeFunction& function);
-    SourcesFunction readAddQmlTargetFunction(const parser::CMakeFunction& function);
-
-    SourcesFunction readFunction(const parser::CMakeFunction& function);
+    // only accessed with std::atomic_load()/std::atomic_store()
+    std::shared_ptr<const CMakeListsFileSnapshotData> published;
+};
 
-    qsizetype commonPrefixLength(const QString& path1, const QString& path2);
+class CMakeListsFileSnapshotData
+{
+public:
+    CMakeListsFileSnapshotData(std::shared_ptr<const CMakeListsFilePrivate::Identity> _file, core::ListFile _state);
 
-    qsizetype commonPrefixScore(const QString& filePath, const Section& section);
+    QStringList targetsOfSourceFile(const QString& fileName) const;
 
-    QString preferedSectionName(const QString& functionName, const QString& fileName, const QMimeType& mimeType);
+    const std::shared_ptr<const CMakeListsFilePrivate::Identity> file;
+    const core::ListFile state;
 
 private:
-    CMakeListsFile* q_ptr;
-    Q_DECLARE_PUBLIC(CMakeListsFile)
-
-public:
-    QByteArray originalFileContent;
-    bool loaded;
-    QList<SourcesFunction> sourcesFunctions;
-    QMap<QString, QList<qsizetype>> sourcesFunctionsIndex;
-    SortSectionPolicy sortSectionPolicy;
+    // file name -> targets, built on first use
+    mutable std::once_flag sourceFileTargetsBuilt{};
+    mutable QHash<QString, QStringList> sourceFileTargets{};
 };
 
 } // namespace cmle
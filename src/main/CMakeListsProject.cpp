@@ -0,0 +1,596 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "include/cmle/CMakeListsProject.h"
+
+#include "include/cmle/AsyncFileLoader.h"
+#include "include/cmle/CMakeListsFile.h"
+#include "include/cmle/StandardFileBuffer.h"
+#include "ProjectCache_p.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileSystemWatcher>
+#include <QFileInfo>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <algorithm>
+#include <tuple>
+
+namespace cmle {
+
+namespace {
+
+const QLoggingCategory CMAKE{"com.va.cmakelistsedit"};
+
+const QString kListsFileName = QStringLiteral("CMakeLists.txt"); // clazy:exclude=non-pod-global-static
+
+QStringList globListsFiles(const QString& rootDir)
+{
+    QStringList output;
+
+    QDirIterator it{rootDir, {kListsFileName}, QDir::Files, QDirIterator::Subdirectories};
+    while (it.hasNext())
+    {
+        const QFileInfo fileInfo{it.next()};
+
+        // skip build trees, they contain copies of or generated CMakeLists files
+        bool inBuildTree = false;
+        for (QDir dir = fileInfo.dir(); dir.absolutePath().startsWith(rootDir) && dir.absolutePath() != rootDir;
+             dir.cdUp())
+        {
+            if (dir.exists(QStringLiteral("CMakeCache.txt")))
+            {
+                inBuildTree = true;
+                break;
+            }
+        }
+
+        if (!inBuildTree)
+            output << QDir::cleanPath(fileInfo.absoluteFilePath());
+    }
+
+    output.sort();
+    return output;
+}
+
+QStringList subFileNames(const QString& fileName, const QStringList& subdirectories)
+{
+    QStringList output;
+
+    const QDir dir = QFileInfo{fileName}.dir();
+    for (const auto& subdirectory : subdirectories)
+    {
+        output << QDir::cleanPath(dir.absoluteFilePath(subdirectory) + QLatin1Char('/') + kListsFileName);
+    }
+
+    return output;
+}
+
+bool sameSections(const QList<CMakeListsFile::SourcesSection>& a, const QList<CMakeListsFile::SourcesSection>& b)
+{
+    return std::equal(a.cbegin(), a.cend(), b.cbegin(), b.cend(), [](const auto& x, const auto& y) {
+        return x.name == y.name && x.fileNames == y.fileNames;
+    });
+}
+
+bool sameBlock(const CMakeListsFile::SourcesBlock& a, const CMakeListsFile::SourcesBlock& b)
+{
+    return a.functionName == b.functionName && a.target == b.target && a.startLine == b.startLine &&
+            a.endLine == b.endLine && sameSections(a.sections, b.sections);
+}
+
+QMap<QString, QList<CMakeListsFile::SourcesBlock>> blocksByTarget(const QList<CMakeListsFile::SourcesBlock>& blocks)
+{
+    QMap<QString, QList<CMakeListsFile::SourcesBlock>> output;
+    for (const auto& block : blocks)
+    {
+        output[block.target] << block;
+    }
+    return output;
+}
+
+} // namespace
+
+// *********************************************************************************************************************
+
+class CMakeListsProjectPrivate
+{
+public:
+    CMakeListsProjectPrivate(CMakeListsProject* q) :
+        q_ptr{q}
+    {
+    }
+
+    struct Entry
+    {
+        ProjectCacheEntry summary{};
+        // parsed on demand if the summary was taken from the cache
+        QSharedPointer<CMakeListsFile> file{};
+    };
+
+    void clear();
+    QSharedPointer<CMakeListsFile> parse(const QString& fileName, Entry& entry) const;
+    bool read(const QString& fileName, Entry& entry) const;
+
+    void watch(const QStringList& fileNames);
+    void onFileChanged(const QString& fileName);
+    void addFile(const QString& fileName, QSet<QString>& changedTargets);
+    void updateTargetIndex(const QString& fileName, const QList<CMakeListsFile::SourcesBlock>& oldBlocks,
+                           const QList<CMakeListsFile::SourcesBlock>& newBlocks, QSet<QString>& changedTargets);
+
+    QString rootFileName{};
+    SubdirectoryDiscovery subdirectoryDiscovery{SubdirectoryDiscovery::AddSubdirectory};
+    QString cacheFileName{};
+    QStringList fileNames{};
+    mutable QHash<QString, Entry> files{};
+    // position in fileNames, kept monotonic when files are added or removed
+    QHash<QString, qsizetype> fileOrder{};
+    QMap<QString, QList<CMakeListsProject::TargetLocation>> targetIndex{};
+    QScopedPointer<QFileSystemWatcher> watcher{};
+
+private:
+    CMakeListsProject* q_ptr;
+    Q_DECLARE_PUBLIC(CMakeListsProject)
+};
+
+void CMakeListsProjectPrivate::clear()
+{
+    rootFileName.clear();
+    fileNames.clear();
+    files.clear();
+    fileOrder.clear();
+    targetIndex.clear();
+
+    if (watcher && !watcher->files().isEmpty())
+        watcher->removePaths(watcher->files());
+}
+
+QSharedPointer<CMakeListsFile> CMakeListsProjectPrivate::parse(const QString& fileName, Entry& entry) const
+{
+    StandardFileBuffer buffer{fileName};
+    if (!buffer.load())
+        return {};
+
+    auto file = QSharedPointer<CMakeListsFile>::create(buffer);
+    if (!file->isLoaded())
+    {
+        qCWarning(CMAKE) << "Could not parse" << fileName;
+        return {};
+    }
+
+    entry.file = file;
+    return file;
+}
+
+bool CMakeListsProjectPrivate::read(const QString& fileName, Entry& entry) const
+{
+    const QFileInfo fileInfo{fileName};
+    const qint64 size = fileInfo.size();
+    const qint64 modified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    StandardFileBuffer buffer{fileName};
+    if (!buffer.load())
+        return false;
+
+    entry.file = QSharedPointer<CMakeListsFile>::create(buffer);
+    if (!entry.file->isLoaded())
+    {
+        qCWarning(CMAKE) << "Could not parse" << fileName;
+        entry.file.reset();
+        return false;
+    }
+
+    entry.summary.hash = QCryptographicHash::hash(buffer.content(), QCryptographicHash::Sha1);
+    entry.summary.size = size;
+    entry.summary.modified = modified;
+    entry.summary.subdirectories = entry.file->subdirectories();
+    entry.summary.blocks = entry.file->sourcesBlocks();
+
+    return true;
+}
+
+void CMakeListsProjectPrivate::watch(const QStringList& fileNames)
+{
+    if (!watcher)
+        return;
+
+    QStringList missing;
+    const auto watched = watcher->files();
+    for (const auto& fileName : fileNames)
+    {
+        if (!watched.contains(fileName))
+            missing << fileName;
+    }
+
+    if (!missing.isEmpty())
+        watcher->addPaths(missing);
+}
+
+void CMakeListsProjectPrivate::onFileChanged(const QString& fileName)
+{
+    Q_Q(CMakeListsProject);
+
+    auto pos = files.find(fileName);
+    if (pos == files.end())
+        return;
+
+    QSet<QString> changedTargets;
+
+    if (!QFileInfo::exists(fileName))
+    {
+        updateTargetIndex(fileName, pos->summary.blocks, {}, changedTargets);
+        files.erase(pos);
+        fileNames.removeOne(fileName);
+        fileOrder.remove(fileName);
+    }
+    else
+    {
+        // replacing the file removes it from the watcher
+        watch({fileName});
+
+        Entry entry;
+        if (!read(fileName, entry))
+            return;
+
+        // our own writes and touching the file also trigger the watcher
+        if (entry.summary.hash == pos->summary.hash)
+        {
+            pos->summary.size = entry.summary.size;
+            pos->summary.modified = entry.summary.modified;
+            return;
+        }
+
+        const auto oldBlocks = pos->summary.blocks;
+        *pos = entry;
+        updateTargetIndex(fileName, oldBlocks, entry.summary.blocks, changedTargets);
+
+        // files added by new add_subdirectory() calls, removed ones are only dropped by the next load()
+        const auto subFiles = subFileNames(fileName, entry.summary.subdirectories);
+        for (const auto& subFile : subFiles)
+        {
+            addFile(subFile, changedTargets);
+        }
+    }
+
+    emit q->fileChanged(fileName);
+
+    if (!changedTargets.isEmpty())
+    {
+        QStringList targets = changedTargets.values();
+        targets.sort();
+        emit q->targetsChanged(targets);
+    }
+}
+
+void CMakeListsProjectPrivate::addFile(const QString& fileName, QSet<QString>& changedTargets)
+{
+    if (files.contains(fileName) || !QFileInfo::exists(fileName))
+        return;
+
+    Entry entry;
+    if (!read(fileName, entry))
+        return;
+
+    fileOrder.insert(fileName, fileNames.isEmpty() ? 0 : fileOrder.value(fileNames.last()) + 1);
+    fileNames << fileName;
+    files.insert(fileName, entry);
+    watch({fileName});
+
+    updateTargetIndex(fileName, {}, entry.summary.blocks, changedTargets);
+
+    const auto subFiles = subFileNames(fileName, entry.summary.subdirectories);
+    for (const auto& subFile : subFiles)
+    {
+        addFile(subFile, changedTargets);
+    }
+}
+
+void CMakeListsProjectPrivate::updateTargetIndex(const QString& fileName,
+                                                 const QList<CMakeListsFile::SourcesBlock>& oldBlocks,
+                                                 const QList<CMakeListsFile::SourcesBlock>& newBlocks,
+                                                 QSet<QString>& changedTargets)
+{
+    const auto oldTargets = blocksByTarget(oldBlocks);
+    const auto newTargets = blocksByTarget(newBlocks);
+
+    QSet<QString> targets;
+    for (auto it = oldTargets.cbegin(); it != oldTargets.cend(); ++it)
+    {
+        const auto& newTargetBlocks = newTargets.value(it.key());
+        if (!std::equal(it->cbegin(), it->cend(), newTargetBlocks.cbegin(), newTargetBlocks.cend(), sameBlock))
+            targets.insert(it.key());
+    }
+    for (auto it = newTargets.cbegin(); it != newTargets.cend(); ++it)
+    {
+        if (!oldTargets.contains(it.key()))
+            targets.insert(it.key());
+    }
+
+    const qsizetype order = fileOrder.value(fileName);
+
+    for (const auto& target : qAsConst(targets))
+    {
+        auto& locations = targetIndex[target];
+        locations.removeIf([&fileName](const auto& location) { return location.fileName == fileName; });
+
+        // keep the locations in file order
+        auto insertPos = std::find_if(locations.begin(), locations.end(), [this, order](const auto& location) {
+            return fileOrder.value(location.fileName) > order;
+        });
+        const auto blocks = newTargets.value(target);
+        for (const auto& block : blocks)
+        {
+            insertPos = locations.insert(insertPos, CMakeListsProject::TargetLocation{
+                                                        fileName, block.functionName, block.startLine, block.endLine});
+            ++insertPos;
+        }
+
+        if (locations.isEmpty())
+            targetIndex.remove(target);
+    }
+
+    changedTargets.unite(targets);
+}
+
+// *********************************************************************************************************************
+
+CMakeListsProject::CMakeListsProject(QObject* parent) :
+    QObject{parent},
+    d_ptr{new CMakeListsProjectPrivate{this}}
+{
+}
+
+CMakeListsProject::~CMakeListsProject() = default;
+
+void CMakeListsProject::setSubdirectoryDiscovery(SubdirectoryDiscovery subdirectoryDiscovery)
+{
+    Q_D(CMakeListsProject);
+    d->subdirectoryDiscovery = subdirectoryDiscovery;
+}
+
+QString CMakeListsProject::cacheFileName() const
+{
+    Q_D(const CMakeListsProject);
+    return d->cacheFileName;
+}
+
+void CMakeListsProject::setCacheFileName(const QString& cacheFileName)
+{
+    Q_D(CMakeListsProject);
+    d->cacheFileName = cacheFileName;
+}
+
+bool CMakeListsProject::isWatching() const
+{
+    Q_D(const CMakeListsProject);
+    return !d->watcher.isNull();
+}
+
+void CMakeListsProject::setWatching(bool watching)
+{
+    Q_D(CMakeListsProject);
+
+    if (watching == isWatching())
+        return;
+
+    if (!watching)
+    {
+        d->watcher.reset();
+        return;
+    }
+
+    d->watcher.reset(new QFileSystemWatcher);
+    connect(d->watcher.data(), &QFileSystemWatcher::fileChanged, this, [d](const QString& fileName) {
+        d->onFileChanged(fileName);
+    });
+    d->watch(d->fileNames);
+}
+
+bool CMakeListsProject::load(const QString& rootFileName)
+{
+    Q_D(CMakeListsProject);
+
+    d->clear();
+    d->rootFileName = QDir::cleanPath(QFileInfo{rootFileName}.absoluteFilePath());
+
+    QStringList discoveryOrder{d->rootFileName};
+    QSet<QString> seen{d->rootFileName};
+
+    if (d->subdirectoryDiscovery == SubdirectoryDiscovery::AddSubdirectoryAndGlob)
+    {
+        const auto globbed = globListsFiles(QFileInfo{d->rootFileName}.absolutePath());
+        for (const auto& fileName : globbed)
+        {
+            if (!seen.contains(fileName))
+            {
+                seen.insert(fileName);
+                discoveryOrder << fileName;
+            }
+        }
+    }
+
+    ProjectCache cache;
+    if (!d->cacheFileName.isEmpty())
+        readProjectCache(d->cacheFileName, cache);
+    bool cacheChanged = false;
+
+    QThread* ownerThread = thread();
+    QMutex mutex;
+    bool success = true;
+
+    AsyncFileLoader loader;
+    QStringList pending = discoveryOrder;
+
+    // every round loads the files discovered by the previous one
+    while (!pending.isEmpty())
+    {
+        QStringList discovered;
+        QStringList toLoad;
+        QHash<QString, std::pair<qint64, qint64>> fileStats;
+
+        for (const auto& fileName : qAsConst(pending))
+        {
+            // stat before reading, a file changed in between is detected on the next load
+            const QFileInfo fileInfo{fileName};
+            const qint64 size = fileInfo.size();
+            const qint64 modified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+            const auto cached = cache.constFind(fileName);
+            if (cached != cache.cend() && cached->modified >= 0 && cached->size == size &&
+                    cached->modified == modified)
+            {
+                d->files.insert(fileName, {*cached, {}});
+                discovered << subFileNames(fileName, cached->subdirectories);
+            }
+            else
+            {
+                toLoad << fileName;
+                fileStats.insert(fileName, {size, modified});
+            }
+        }
+
+        loader.load(toLoad, [&](const QString& fileName, const QByteArray& content, bool loaded) {
+            if (!loaded)
+            {
+                qCWarning(CMAKE) << "Could not load" << fileName;
+                QMutexLocker lock{&mutex};
+                success = false;
+                return;
+            }
+
+            CMakeListsProjectPrivate::Entry entry;
+            entry.summary.hash = QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+
+            // only touched, the content is still the one in the cache
+            const auto cached = cache.constFind(fileName);
+            if (cached != cache.cend() && cached->hash == entry.summary.hash)
+            {
+                entry.summary = *cached;
+            }
+            else
+            {
+                entry.file = QSharedPointer<CMakeListsFile>::create(content);
+                if (!entry.file->isLoaded())
+                {
+                    qCWarning(CMAKE) << "Could not parse" << fileName;
+                    QMutexLocker lock{&mutex};
+                    success = false;
+                    return;
+                }
+                entry.file->moveToThread(ownerThread);
+
+                entry.summary.subdirectories = entry.file->subdirectories();
+                entry.summary.blocks = entry.file->sourcesBlocks();
+            }
+
+            std::tie(entry.summary.size, entry.summary.modified) = fileStats.value(fileName);
+
+            QMutexLocker lock{&mutex};
+            discovered << subFileNames(fileName, entry.summary.subdirectories);
+            d->files.insert(fileName, entry);
+            cacheChanged = true;
+        });
+
+        pending.clear();
+        for (const auto& fileName : qAsConst(discovered))
+        {
+            if (!seen.contains(fileName))
+            {
+                seen.insert(fileName);
+                discoveryOrder << fileName;
+                pending << fileName;
+            }
+        }
+    }
+
+    for (const auto& fileName : qAsConst(discoveryOrder))
+    {
+        if (d->files.contains(fileName))
+        {
+            d->fileOrder.insert(fileName, d->fileNames.size());
+            d->fileNames << fileName;
+        }
+    }
+
+    d->watch(d->fileNames);
+
+    if (!d->cacheFileName.isEmpty() && (cacheChanged || cache.size() != d->files.size()))
+    {
+        ProjectCache output;
+        output.reserve(d->files.size());
+        for (auto it = d->files.cbegin(); it != d->files.cend(); ++it)
+        {
+            output.insert(it.key(), it->summary);
+        }
+        writeProjectCache(d->cacheFileName, d->fileNames, output);
+    }
+
+    updateTargetIndex();
+
+    return success;
+}
+
+QString CMakeListsProject::rootFileName() const
+{
+    Q_D(const CMakeListsProject);
+    return d->rootFileName;
+}
+
+QStringList CMakeListsProject::fileNames() const
+{
+    Q_D(const CMakeListsProject);
+    return d->fileNames;
+}
+
+QSharedPointer<CMakeListsFile> CMakeListsProject::file(const QString& fileName) const
+{
+    Q_D(const CMakeListsProject);
+
+    const auto pos = d->files.find(QDir::cleanPath(QFileInfo{fileName}.absoluteFilePath()));
+    if (pos == d->files.end())
+        return {};
+
+    if (pos->file)
+        return pos->file;
+
+    return d->parse(pos.key(), *pos);
+}
+
+QStringList CMakeListsProject::targets() const
+{
+    Q_D(const CMakeListsProject);
+    return d->targetIndex.keys();
+}
+
+QList<CMakeListsProject::TargetLocation> CMakeListsProject::targetLocations(const QString& target) const
+{
+    Q_D(const CMakeListsProject);
+    return d->targetIndex.value(target);
+}
+
+void CMakeListsProject::updateTargetIndex()
+{
+    Q_D(CMakeListsProject);
+
+    d->targetIndex.clear();
+    for (const auto& fileName : qAsConst(d->fileNames))
+    {
+        auto& entry = d->files[fileName];
+        if (entry.file)
+            entry.summary.blocks = entry.file->sourcesBlocks();
+
+        for (const auto& block : qAsConst(entry.summary.blocks))
+        {
+            d->targetIndex[block.target] << TargetLocation{fileName, block.functionName, block.startLine,
+                                                           block.endLine};
+        }
+    }
+}
+
+} // namespace cmle
@@ -0,0 +1,149 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "include/cmle/MappedFileBuffer.h"
+
+#include <QFile>
+#include <QLoggingCategory>
+#include <limits>
+#include <memory>
+
+namespace cmle {
+
+namespace {
+
+const QLoggingCategory CMAKE{"CMAKE"};
+
+} // namespace
+
+// *********************************************************************************************************************
+
+class MappedFileBufferPrivate
+{
+public:
+    MappedFileBufferPrivate(MappedFileBuffer* q) :
+        q_ptr{q}
+    {
+    }
+
+    void unmap();
+
+    QString fileName{};
+    // shared with the CMakeListsFiles read from the mapping, see contentOwner()
+    std::shared_ptr<QFile> file{};
+    QByteArray fileContent{};
+    bool dirty{};
+
+private:
+    MappedFileBuffer* q_ptr;
+    Q_DECLARE_PUBLIC(MappedFileBuffer)
+};
+
+void MappedFileBufferPrivate::unmap()
+{
+    fileContent.clear();
+    // closing the file releases all of its mappings, once nothing else holds it
+    file.reset();
+}
+
+// *********************************************************************************************************************
+
+MappedFileBuffer::~MappedFileBuffer()
+{
+    Q_D(MappedFileBuffer);
+    d->unmap();
+}
+
+MappedFileBuffer::MappedFileBuffer() :
+    MappedFileBuffer(QString{})
+{
+}
+
+MappedFileBuffer::MappedFileBuffer(const QString& fileName) :
+    d_ptr{new MappedFileBufferPrivate{this}}
+{
+    setFileName(fileName);
+}
+
+bool MappedFileBuffer::isDirty() const
+{
+    Q_D(const MappedFileBuffer);
+    return d->dirty;
+}
+
+QString MappedFileBuffer::fileName() const
+{
+    Q_D(const MappedFileBuffer);
+    return d->fileName;
+}
+
+void MappedFileBuffer::setFileName(const QString& fileName)
+{
+    Q_D(MappedFileBuffer);
+    d->fileName = fileName;
+}
+
+bool MappedFileBuffer::load()
+{
+    Q_D(MappedFileBuffer);
+
+    Q_ASSERT(!d->fileName.isEmpty());
+
+    d->unmap();
+    d->dirty = false;
+
+    d->file = std::make_shared<QFile>(d->fileName);
+    if (!d->file->open(QFile::ReadOnly))
+    {
+        qCCritical(CMAKE) << "Could not open" << d->fileName << "for reading";
+        return false;
+    }
+
+    const qint64 size = d->file->size();
+    if (size > qint64{std::numeric_limits<qsizetype>::max()})
+    {
+        qCCritical(CMAKE) << "File" << d->fileName << "is too large";
+        d->file.reset();
+        return false;
+    }
+
+    // mapping an empty file is not possible
+    if (size == 0)
+        return true;
+
+    const uchar* data = d->file->map(0, size);
+    if (!data)
+    {
+        qCCritical(CMAKE) << "Could not map file" << d->fileName << ":" << d->file->errorString();
+        d->file.reset();
+        return false;
+    }
+
+    d->fileContent = QByteArray::fromRawData(reinterpret_cast<const char*>(data), static_cast<qsizetype>(size));
+
+    return true;
+}
+
+QByteArray MappedFileBuffer::content() const
+{
+    Q_D(const MappedFileBuffer);
+    return d->fileContent;
+}
+
+std::shared_ptr<const void> MappedFileBuffer::contentOwner() const
+{
+    Q_D(const MappedFileBuffer);
+    // content set by setContent() is on the heap
+    if (d->dirty || d->fileContent.isEmpty())
+        return {};
+    return d->file;
+}
+
+void MappedFileBuffer::setContent(const QByteArray& content)
+{
+    Q_D(MappedFileBuffer);
+    d->fileContent = content;
+    d->dirty = true;
+}
+
+} // namespace cmle
@@ -0,0 +1,370 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "ProjectCache_p.h"
+
+#include "include/cmle/MappedFileBuffer.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+
+namespace cmle {
+
+namespace {
+
+const QLoggingCategory CMAKE{"com.va.cmakelistsedit"};
+
+constexpr char kMagic[8] = {'C', 'M', 'L', 'E', 'C', 'A', 'C', 'H'};
+constexpr quint32 kVersion = 1;
+
+constexpr qsizetype kHeaderSize = 48;
+constexpr qsizetype kFileRecordSize = 64;
+constexpr qsizetype kBlockRecordSize = 24;
+constexpr qsizetype kSectionRecordSize = 12;
+constexpr qsizetype kIndexRecordSize = 4;
+constexpr qsizetype kStringRecordSize = 8;
+
+constexpr qsizetype kHashSize = 20;
+
+// files modified shortly before writing the cache could be modified again within the time stamp resolution
+constexpr qint64 kRacyModificationMs = 2000;
+
+class CacheReader
+{
+public:
+    CacheReader(const QByteArray& data) :
+        data_{data}
+    {
+    }
+
+    bool readHeader()
+    {
+        if (data_.size() < kHeaderSize || std::memcmp(data_.constData(), kMagic, sizeof(kMagic)) != 0)
+            return false;
+        if (u32(8) != kVersion)
+            return false;
+
+        fileCount_ = u32(12);
+        blockCount_ = u32(16);
+        sectionCount_ = u32(20);
+        indexCount_ = u32(24);
+        stringCount_ = u32(28);
+        const quint64 stringDataSize = qFromLittleEndian<quint64>(data_.constData() + 32);
+
+        filesOffset_ = kHeaderSize;
+        blocksOffset_ = filesOffset_ + fileCount_ * kFileRecordSize;
+        sectionsOffset_ = blocksOffset_ + blockCount_ * kBlockRecordSize;
+        indicesOffset_ = sectionsOffset_ + sectionCount_ * kSectionRecordSize;
+        stringsOffset_ = indicesOffset_ + indexCount_ * kIndexRecordSize;
+        stringDataOffset_ = stringsOffset_ + stringCount_ * kStringRecordSize;
+
+        return stringDataOffset_ <= data_.size() &&
+                static_cast<quint64>(data_.size() - stringDataOffset_) == stringDataSize;
+    }
+
+    bool readFile(qsizetype fileIndex, QString& path, ProjectCacheEntry& entry)
+    {
+        const qsizetype record = filesOffset_ + fileIndex * kFileRecordSize;
+
+        const quint32 firstBlock = u32(record + 4);
+        const quint32 blockCount = u32(record + 8);
+        const quint32 firstSubdirectory = u32(record + 12);
+        const quint32 subdirectoryCount = u32(record + 16);
+
+        if (!string(u32(record), path) ||
+                !inRange(firstBlock, blockCount, blockCount_) ||
+                !inRange(firstSubdirectory, subdirectoryCount, indexCount_))
+            return false;
+
+        entry.size = qFromLittleEndian<qint64>(data_.constData() + record + 24);
+        entry.modified = qFromLittleEndian<qint64>(data_.constData() + record + 32);
+        entry.hash = data_.mid(record + 40, kHashSize);
+
+        if (!strings(firstSubdirectory, subdirectoryCount, entry.subdirectories))
+            return false;
+
+        entry.blocks.reserve(blockCount);
+        for (quint32 i = firstBlock; i < firstBlock + blockCount; ++i)
+        {
+            const qsizetype blockRecord = blocksOffset_ + i * kBlockRecordSize;
+
+            CMakeListsFile::SourcesBlock block{};
+            const quint32 firstSection = u32(blockRecord + 16);
+            const quint32 sectionCount = u32(blockRecord + 20);
+
+            if (!string(u32(blockRecord), block.functionName) ||
+                    !string(u32(blockRecord + 4), block.target) ||
+                    !inRange(firstSection, sectionCount, sectionCount_))
+                return false;
+
+            block.startLine = static_cast<int>(u32(blockRecord + 8));
+            block.endLine = static_cast<int>(u32(blockRecord + 12));
+
+            for (quint32 j = firstSection; j < firstSection + sectionCount; ++j)
+            {
+                const qsizetype sectionRecord = sectionsOffset_ + j * kSectionRecordSize;
+
+                CMakeListsFile::SourcesSection section{};
+                const quint32 firstSource = u32(sectionRecord + 4);
+                const quint32 sourceCount = u32(sectionRecord + 8);
+
+                if (!string(u32(sectionRecord), section.name) ||
+                        !inRange(firstSource, sourceCount, indexCount_) ||
+                        !strings(firstSource, sourceCount, section.fileNames))
+                    return false;
+
+                block.sections << section;
+            }
+
+            entry.blocks << block;
+        }
+
+        return true;
+    }
+
+    quint32 fileCount() const { return fileCount_; }
+
+private:
+    quint32 u32(qsizetype offset) const
+    {
+        return qFromLittleEndian<quint32>(data_.constData() + offset);
+    }
+
+    static bool inRange(quint32 first, quint32 count, quint32 size)
+    {
+        return first <= size && count <= size - first;
+    }
+
+    bool string(quint32 index, QString& output)
+    {
+        if (index >= stringCount_)
+            return false;
+
+        const qsizetype record = stringsOffset_ + index * kStringRecordSize;
+        const quint32 offset = u32(record);
+        const quint32 length = u32(record + 4);
+        if (stringDataOffset_ + offset + length > data_.size())
+            return false;
+
+        output = QString::fromUtf8(data_.constData() + stringDataOffset_ + offset, length);
+        return true;
+    }
+
+    bool strings(quint32 first, quint32 count, QStringList& output)
+    {
+        output.reserve(count);
+        for (quint32 i = first; i < first + count; ++i)
+        {
+            QString value;
+            if (!string(u32(indicesOffset_ + i * kIndexRecordSize), value))
+                return false;
+            output << value;
+        }
+        return true;
+    }
+
+private:
+    const QByteArray& data_;
+    quint32 fileCount_{};
+    quint32 blockCount_{};
+    quint32 sectionCount_{};
+    quint32 indexCount_{};
+    quint32 stringCount_{};
+    qsizetype filesOffset_{};
+    qsizetype blocksOffset_{};
+    qsizetype sectionsOffset_{};
+    qsizetype indicesOffset_{};
+    qsizetype stringsOffset_{};
+    qsizetype stringDataOffset_{};
+};
+
+class CacheWriter
+{
+public:
+    void addFile(const QString& path, const ProjectCacheEntry& entry, qint64 racyModified)
+    {
+        const auto firstBlock = static_cast<quint32>(blockCount_);
+        for (const auto& block : entry.blocks)
+        {
+            const auto firstSection = static_cast<quint32>(sectionCount_);
+            for (const auto& section : block.sections)
+            {
+                const auto firstSource = static_cast<quint32>(indexCount_);
+                for (const auto& fileName : section.fileNames)
+                {
+                    append(indices_, stringIndex(fileName));
+                    ++indexCount_;
+                }
+
+                append(sections_, stringIndex(section.name));
+                append(sections_, firstSource);
+                append(sections_, static_cast<quint32>(section.fileNames.size()));
+                ++sectionCount_;
+            }
+
+            append(blocks_, stringIndex(block.functionName));
+            append(blocks_, stringIndex(block.target));
+            append(blocks_, static_cast<quint32>(block.startLine));
+            append(blocks_, static_cast<quint32>(block.endLine));
+            append(blocks_, firstSection);
+            append(blocks_, static_cast<quint32>(block.sections.size()));
+            ++blockCount_;
+        }
+
+        const auto firstSubdirectory = static_cast<quint32>(indexCount_);
+        for (const auto& subdirectory : entry.subdirectories)
+        {
+            append(indices_, stringIndex(subdirectory));
+            ++indexCount_;
+        }
+
+        append(files_, stringIndex(path));
+        append(files_, firstBlock);
+        append(files_, static_cast<quint32>(entry.blocks.size()));
+        append(files_, firstSubdirectory);
+        append(files_, static_cast<quint32>(entry.subdirectories.size()));
+        append(files_, quint32{0});
+        append(files_, entry.size);
+        append(files_, entry.modified >= racyModified ? qint64{-1} : entry.modified);
+        const QByteArray hash = entry.hash.left(kHashSize);
+        files_.append(hash);
+        files_.append(QByteArray(kHashSize - hash.size(), '\0'));
+        append(files_, quint32{0});
+        ++fileCount_;
+    }
+
+    QByteArray data() const
+    {
+        QByteArray output;
+        output.reserve(kHeaderSize + files_.size() + blocks_.size() + sections_.size() + indices_.size() +
+                       strings_.size() + stringData_.size());
+
+        output.append(kMagic, sizeof(kMagic));
+        append(output, kVersion);
+        append(output, static_cast<quint32>(fileCount_));
+        append(output, static_cast<quint32>(blockCount_));
+        append(output, static_cast<quint32>(sectionCount_));
+        append(output, static_cast<quint32>(indexCount_));
+        append(output, static_cast<quint32>(stringIndices_.size()));
+        append(output, static_cast<quint64>(stringData_.size()));
+        append(output, quint64{0});
+
+        output.append(files_);
+        output.append(blocks_);
+        output.append(sections_);
+        output.append(indices_);
+        output.append(strings_);
+        output.append(stringData_);
+
+        return output;
+    }
+
+private:
+    template<typename T>
+    static void append(QByteArray& output, T value)
+    {
+        char buffer[sizeof(T)];
+        qToLittleEndian(value, buffer);
+        output.append(buffer, sizeof(T));
+    }
+
+    quint32 stringIndex(const QString& value)
+    {
+        auto pos = stringIndices_.constFind(value);
+        if (pos != stringIndices_.cend())
+            return *pos;
+
+        const QByteArray utf8 = value.toUtf8();
+        append(strings_, static_cast<quint32>(stringData_.size()));
+        append(strings_, static_cast<quint32>(utf8.size()));
+        stringData_.append(utf8);
+
+        const auto index = static_cast<quint32>(stringIndices_.size());
+        stringIndices_.insert(value, index);
+        return index;
+    }
+
+private:
+    QByteArray files_{};
+    QByteArray blocks_{};
+    QByteArray sections_{};
+    QByteArray indices_{};
+    QByteArray strings_{};
+    QByteArray stringData_{};
+    QHash<QString, quint32> stringIndices_{};
+    qsizetype fileCount_{};
+    qsizetype blockCount_{};
+    qsizetype sectionCount_{};
+    qsizetype indexCount_{};
+};
+
+} // namespace
+
+bool readProjectCache(const QString& fileName, ProjectCache& cache)
+{
+    if (!QFileInfo::exists(fileName))
+        return false;
+
+    MappedFileBuffer buffer{fileName};
+    if (!buffer.load())
+        return false;
+
+    const QByteArray data = buffer.content();
+    CacheReader reader{data};
+    if (!reader.readHeader())
+    {
+        qCWarning(CMAKE) << "Ignoring invalid project cache" << fileName;
+        return false;
+    }
+
+    ProjectCache output;
+    output.reserve(reader.fileCount());
+    for (quint32 i = 0; i < reader.fileCount(); ++i)
+    {
+        QString path;
+        ProjectCacheEntry entry;
+        if (!reader.readFile(i, path, entry))
+        {
+            qCWarning(CMAKE) << "Ignoring invalid project cache" << fileName;
+            return false;
+        }
+        output.insert(path, entry);
+    }
+
+    cache = std::move(output);
+    return true;
+}
+
+bool writeProjectCache(const QString& fileName, const QStringList& fileNames, const ProjectCache& cache)
+{
+    const qint64 racyModified = QDateTime::currentMSecsSinceEpoch() - kRacyModificationMs;
+
+    CacheWriter writer;
+    for (const auto& path : fileNames)
+    {
+        const auto pos = cache.constFind(path);
+        if (pos != cache.cend())
+            writer.addFile(path, *pos, racyModified);
+    }
+
+    QSaveFile file{fileName};
+    if (!file.open(QFile::WriteOnly))
+    {
+        qCWarning(CMAKE) << "Could not open project cache" << fileName << "for writing";
+        return false;
+    }
+
+    const QByteArray data = writer.data();
+    if (file.write(data) != data.size() || !file.commit())
+    {
+        qCWarning(CMAKE) << "Could not write project cache" << fileName;
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace cmle
@@ -0,0 +1,37 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "include/cmle/CMakeListsFile.h"
+#include <QHash>
+
+namespace cmle {
+
+// Everything CMakeListsProject needs to know about a file without parsing it.
+struct ProjectCacheEntry
+{
+    QByteArray hash{};
+    qint64 size{-1};
+    // modification time in ms since epoch, -1 forces a content check
+    qint64 modified{-1};
+    QStringList subdirectories{};
+    QList<CMakeListsFile::SourcesBlock> blocks{};
+};
+
+using ProjectCache = QHash<QString, ProjectCacheEntry>;
+
+// The cache is a single little endian binary file made of fixed size records, so it can be read directly from a
+// memory mapping:
+//
+//   header     magic "CMLECACH", version, record counts and size of the string data
+//   files      path, blocks, subdirectories, size, modification time and SHA-1 of the content
+//   blocks     function name, target, start/end line and sections of a source defining function
+//   sections   name and file names
+//   indices    string indices referenced by sections (file names) and files (subdirectories)
+//   strings    offset and length into the string data
+//   data       UTF-8 string data, every distinct string is stored once
+bool readProjectCache(const QString& fileName, ProjectCache& cache);
+bool writeProjectCache(const QString& fileName, const QStringList& fileNames, const ProjectCache& cache);
+
+} // namespace cmle
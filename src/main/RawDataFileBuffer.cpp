@@ -0,0 +1,61 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "include/cmle/RawDataFileBuffer.h"
+
+namespace cmle {
+
+class RawDataFileBufferPrivate
+{
+public:
+    RawDataFileBufferPrivate(RawDataFileBuffer* q) :
+        q_ptr{q}
+    {
+    }
+
+    QString fileName{};
+    QByteArray fileContent{};
+
+private:
+    RawDataFileBuffer* q_ptr;
+    Q_DECLARE_PUBLIC(RawDataFileBuffer)
+};
+
+// *********************************************************************************************************************
+
+RawDataFileBuffer::~RawDataFileBuffer() = default;
+
+RawDataFileBuffer::RawDataFileBuffer() :
+    RawDataFileBuffer(QByteArrayView{})
+{
+}
+
+RawDataFileBuffer::RawDataFileBuffer(QByteArrayView data, const QString& fileName) :
+    d_ptr{new RawDataFileBufferPrivate{this}}
+{
+    Q_D(RawDataFileBuffer);
+    d->fileName = fileName;
+    d->fileContent = QByteArray::fromRawData(data.data(), data.size());
+}
+
+QString RawDataFileBuffer::fileName() const
+{
+    Q_D(const RawDataFileBuffer);
+    if (d->fileName.isEmpty())
+        return QStringLiteral("[RawData]");
+    return d->fileName;
+}
+
+QByteArray RawDataFileBuffer::content() const
+{
+    Q_D(const RawDataFileBuffer);
+    return d->fileContent;
+}
+
+void RawDataFileBuffer::setContent(const QByteArray& content)
+{
+    Q_D(RawDataFileBuffer);
+    d->fileContent = content;
+}
+
+} // namespace cmle
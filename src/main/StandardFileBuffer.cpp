@@ -3,8 +3,14 @@
 
 #include "include/cmle/StandardFileBuffer.h"
 
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
 #include <QLoggingCategory>
+#include <QSaveFile>
+#include <algorithm>
+#include <limits>
 
 namespace cmle {
 
@@ -12,6 +18,11 @@ namespace {
 
 const QLoggingCategory CMAKE{"CMAKE"};
 
+QByteArray contentHash(const QByteArray& content)
+{
+    return QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+}
+
 } // namespace
 
 // *********************************************************************************************************************
@@ -24,15 +35,88 @@ public:
     {
     }
 
+    bool readContent(QFile& file, qsizetype expectedSize);
+    void updateDiskState();
+    bool isUnchangedOnDisk() const;
+
     QString fileName{};
     QByteArray fileContent{};
     bool dirty{};
+    SavePolicy savePolicy{SavePolicy::Overwrite};
+
+    // state of the file on disk after the last load() or save()
+    QByteArray diskHash{};
+    qint64 diskSize{-1};
+    QDateTime diskModified{};
 
 private:
     StandardFileBuffer* q_ptr;
     Q_DECLARE_PUBLIC(StandardFileBuffer)
 };
 
+bool StandardFileBufferPrivate::readContent(QFile& file, qsizetype expectedSize)
+{
+    // Regular files are read with a single call into an exactly sized buffer. Pipes and files which do not report
+    // their real size (like the ones in /proc) are read in growing chunks until EOF.
+    constexpr qsizetype minReadChunkSize = 0x10000;
+    constexpr qsizetype maxContentSize = std::numeric_limits<qsizetype>::max();
+
+    QByteArray content(expectedSize, Qt::Uninitialized);
+    qsizetype readBytes = 0;
+
+    while (true)
+    {
+        if (readBytes == content.size())
+        {
+            if (content.size() == maxContentSize)
+                return false;
+            const qsizetype grow = std::max(content.size(), minReadChunkSize);
+            content.resize(content.size() < maxContentSize - grow ? content.size() + grow : maxContentSize);
+        }
+
+        const qint64 readResult = file.read(content.data() + readBytes, content.size() - readBytes);
+        if (readResult < 0)
+            return false;
+        if (readResult == 0)
+            break;
+
+        readBytes += static_cast<qsizetype>(readResult);
+
+        if (readBytes == expectedSize)
+            break;
+    }
+
+    content.resize(readBytes);
+    fileContent = std::move(content);
+
+    return true;
+}
+
+void StandardFileBufferPrivate::updateDiskState()
+{
+    const QFileInfo fileInfo{fileName};
+    diskHash = contentHash(fileContent);
+    diskSize = fileInfo.size();
+    diskModified = fileInfo.lastModified();
+}
+
+bool StandardFileBufferPrivate::isUnchangedOnDisk() const
+{
+    const QFileInfo fileInfo{fileName};
+    if (!fileInfo.exists() || fileInfo.size() != fileContent.size())
+        return false;
+
+    // file was not touched since we have seen it, so the stored hash is sufficient
+    if (!diskHash.isEmpty() && fileInfo.size() == diskSize && fileInfo.lastModified() == diskModified)
+        return contentHash(fileContent) == diskHash;
+
+    QFile file{fileName};
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    return file.readAll() == fileContent;
+}
+
 // *********************************************************************************************************************
 
 StandardFileBuffer::~StandardFileBuffer() = default;
@@ -48,6 +132,12 @@ StandardFileBuffer::StandardFileBuffer(const QString& fileName) :
     setFileName(fileName);
 }
 
+void StandardFileBuffer::setSavePolicy(SavePolicy savePolicy)
+{
+    Q_D(StandardFileBuffer);
+    d->savePolicy = savePolicy;
+}
+
 bool StandardFileBuffer::isDirty() const
 {
     Q_D(const StandardFileBuffer);
@@ -65,6 +155,7 @@ void StandardFileBuffer::setFileName(const QString& fileName)
 {
     Q_D(StandardFileBuffer);
     d->fileName = fileName;
+    d->diskHash.clear();
 }
 
 bool StandardFileBuffer::load()
@@ -75,36 +166,28 @@ bool StandardFileBuffer::load()
 
     d->dirty = false;
 
+    // unbuffered, so the data is read directly into the content buffer
     QFile file(d->fileName);
-    if (!file.open(QFile::ReadOnly))
+    if (!file.open(QFile::ReadOnly | QFile::Unbuffered))
     {
         qCCritical(CMAKE) << "Could not open" << d->fileName << "for reading";
         return false;
     }
 
-    constexpr qint64 readChunkSize = 0x10000;
-    qint64 readBytes = 0;
-    qint64 readResult{};
-    do
+    const qint64 fileSize = file.isSequential() ? 0 : file.size();
+    if (fileSize > qint64{std::numeric_limits<qsizetype>::max()})
     {
-        if (readBytes + readChunkSize >= qint64{std::numeric_limits<int>::max()})
-            break;
-        d->fileContent.resize(static_cast<int>(readBytes + readChunkSize));
-        readResult = file.read(d->fileContent.data() + readBytes, readChunkSize);
-        if (readResult > 0 || readBytes == 0)
-        {
-            readBytes += readResult;
-        }
+        qCCritical(CMAKE) << "File" << d->fileName << "is too large";
+        return false;
     }
-    while (readResult > 0);
 
-    if (readResult < 0)
+    if (!d->readContent(file, static_cast<qsizetype>(fileSize)))
     {
         qCCritical(CMAKE) << "Error while reading file" << d->fileName;
         return false;
     }
 
-    d->fileContent.resize(static_cast<int>(readBytes));
+    d->updateDiskState();
 
     return true;
 }
@@ -113,8 +196,15 @@ bool StandardFileBuffer::save()
 {
     Q_D(StandardFileBuffer);
 
-    QFile file(d->fileName);
-    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    if (d->savePolicy == SavePolicy::SkipUnchanged && d->isUnchangedOnDisk())
+    {
+        d->dirty = false;
+        return true;
+    }
+
+    // QSaveFile writes to a temporary file, syncs it to disk and renames it over the target on commit()
+    QSaveFile file(d->fileName);
+    if (!file.open(QFile::WriteOnly))
     {
         qCCritical(CMAKE) << "Could not open" << d->fileName << "for writing";
         return false;
@@ -123,10 +213,18 @@ bool StandardFileBuffer::save()
     if (file.write(d->fileContent) != d->fileContent.size())
     {
         qCCritical(CMAKE) << "Could not write all data to file" << d->fileName;
+        file.cancelWriting();
+        return false;
+    }
+
+    if (!file.commit())
+    {
+        qCCritical(CMAKE) << "Could not commit data to file" << d->fileName;
         return false;
     }
 
     d->dirty = false;
+    d->updateDiskState();
 
     return true;
 }
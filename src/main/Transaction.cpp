@@ -0,0 +1,279 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "include/cmle/Transaction.h"
+
+#include "include/cmle/AsyncFileLoader.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QMap>
+#include <QMutex>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <filesystem>
+
+namespace cmle {
+
+namespace {
+
+const QLoggingCategory CMAKE{"com.va.cmakelistsedit"};
+
+const QString kTempTemplate = QStringLiteral(".cmle-XXXXXX"); // clazy:exclude=non-pod-global-static
+
+QString absoluteFileName(const QString& fileName)
+{
+    return QDir::cleanPath(QFileInfo{fileName}.absoluteFilePath());
+}
+
+// Creates an empty file with a unique name next to fileName, so concurrent commits never share a temporary file.
+QString reserveTempFileName(const QString& fileName)
+{
+    QTemporaryFile file{fileName + kTempTemplate};
+    file.setAutoRemove(false);
+    if (!file.open())
+    {
+        qCCritical(CMAKE) << "Could not create a temporary file for" << fileName;
+        return {};
+    }
+    return file.fileName();
+}
+
+bool writeFile(const QString& fileName, const QByteArray& content)
+{
+    // QSaveFile syncs the data before renaming it to fileName
+    QSaveFile file{fileName};
+    if (!file.open(QFile::WriteOnly) || file.write(content) != content.size() || !file.commit())
+    {
+        qCCritical(CMAKE) << "Could not write" << fileName;
+        return false;
+    }
+    return true;
+}
+
+bool replaceFile(const QString& sourceFileName, const QString& targetFileName)
+{
+    std::error_code error;
+    std::filesystem::rename(QFile::encodeName(sourceFileName).toStdString(),
+                            QFile::encodeName(targetFileName).toStdString(), error);
+    if (error)
+    {
+        qCCritical(CMAKE) << "Could not replace" << targetFileName << ':' << error.message().c_str();
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// *********************************************************************************************************************
+
+class TransactionPrivate
+{
+public:
+    enum class OperationType
+    {
+        Add,
+        Rename,
+        Remove
+    };
+
+    struct Operation
+    {
+        OperationType type;
+        QString target;
+        QString fileName;
+        QString newFileName;
+        QMimeType mimeType;
+    };
+
+    struct Result
+    {
+        QByteArray originalContent;
+        QString tempFileName;
+    };
+
+public:
+    TransactionPrivate(Transaction* q) :
+        q_ptr{q}
+    {
+    }
+
+    bool apply(CMakeListsFile& file, const Operation& operation) const;
+
+    SortSectionPolicy sortSectionPolicy{SortSectionPolicy::NoSort};
+    // sorted by file name, so files are always replaced in the same order
+    QMap<QString, QList<Operation>> operations{};
+
+private:
+    Transaction* q_ptr;
+    Q_DECLARE_PUBLIC(Transaction)
+};
+
+bool TransactionPrivate::apply(CMakeListsFile& file, const Operation& operation) const
+{
+    switch (operation.type)
+    {
+    case OperationType::Add:
+        return file.addSourceFile(operation.target, operation.fileName, operation.mimeType);
+    case OperationType::Rename:
+        return file.renameSourceFile(operation.target, operation.fileName, operation.newFileName);
+    case OperationType::Remove:
+        return file.removeSourceFile(operation.target, operation.fileName);
+    }
+    return false;
+}
+
+// *********************************************************************************************************************
+
+Transaction::Transaction() :
+    d_ptr{new TransactionPrivate{this}}
+{
+}
+
+Transaction::~Transaction() = default;
+
+void Transaction::setSortSectionPolicy(SortSectionPolicy sortSectionPolicy)
+{
+    Q_D(Transaction);
+    d->sortSectionPolicy = sortSectionPolicy;
+}
+
+void Transaction::addSourceFile(const QString& cmakeListsFile, const QString& target, const QString& fileName,
+                                const QMimeType& mimeType)
+{
+    Q_D(Transaction);
+    d->operations[absoluteFileName(cmakeListsFile)] << TransactionPrivate::Operation{
+            TransactionPrivate::OperationType::Add, target, fileName, {}, mimeType};
+}
+
+void Transaction::renameSourceFile(const QString& cmakeListsFile, const QString& target, const QString& oldFileName,
+                                   const QString& newFileName)
+{
+    Q_D(Transaction);
+    d->operations[absoluteFileName(cmakeListsFile)] << TransactionPrivate::Operation{
+            TransactionPrivate::OperationType::Rename, target, oldFileName, newFileName, {}};
+}
+
+void Transaction::removeSourceFile(const QString& cmakeListsFile, const QString& target, const QString& fileName)
+{
+    Q_D(Transaction);
+    d->operations[absoluteFileName(cmakeListsFile)] << TransactionPrivate::Operation{
+            TransactionPrivate::OperationType::Remove, target, fileName, {}, {}};
+}
+
+void Transaction::moveSourceFile(const QString& fromCMakeListsFile, const QString& fromTarget,
+                                 const QString& toCMakeListsFile, const QString& toTarget, const QString& fileName,
+                                 const QMimeType& mimeType)
+{
+    removeSourceFile(fromCMakeListsFile, fromTarget, fileName);
+    addSourceFile(toCMakeListsFile, toTarget, fileName, mimeType);
+}
+
+QStringList Transaction::fileNames() const
+{
+    Q_D(const Transaction);
+    return d->operations.keys();
+}
+
+bool Transaction::commit()
+{
+    Q_D(Transaction);
+
+    QMutex mutex;
+    bool success = true;
+    QMap<QString, TransactionPrivate::Result> results;
+
+    // parse, edit and write the temporary files in parallel
+    AsyncFileLoader loader;
+    loader.load(d->operations.keys(), [&](const QString& fileName, const QByteArray& content, bool loaded) {
+        auto fail = [&]() {
+            QMutexLocker lock{&mutex};
+            success = false;
+        };
+
+        if (!loaded)
+            return fail();
+
+        CMakeListsFile file{content};
+        if (!file.isLoaded())
+        {
+            qCCritical(CMAKE) << "Could not parse" << fileName;
+            return fail();
+        }
+        file.setSortSectionPolicy(d->sortSectionPolicy);
+
+        const auto operations = d->operations.value(fileName);
+        for (const auto& operation : operations)
+        {
+            if (!d->apply(file, operation))
+            {
+                qCCritical(CMAKE) << "Could not apply the operations to" << fileName;
+                return fail();
+            }
+        }
+
+        const QByteArray newContent = file.write();
+        if (newContent == content)
+            return;
+
+        const QString tempFileName = reserveTempFileName(fileName);
+        if (tempFileName.isEmpty())
+            return fail();
+        if (!writeFile(tempFileName, newContent))
+        {
+            QFile::remove(tempFileName);
+            return fail();
+        }
+        QFile::setPermissions(tempFileName, QFile::permissions(fileName));
+
+        QMutexLocker lock{&mutex};
+        results.insert(fileName, {content, tempFileName});
+    });
+
+    if (!success)
+    {
+        for (const auto& result : qAsConst(results))
+        {
+            QFile::remove(result.tempFileName);
+        }
+        return false;
+    }
+
+    QStringList replaced;
+    for (auto it = results.cbegin(); it != results.cend(); ++it)
+    {
+        if (!replaceFile(it->tempFileName, it.key()))
+        {
+            success = false;
+            break;
+        }
+        replaced << it.key();
+    }
+
+    if (!success)
+    {
+        // roll back, the files not replaced yet still have their original content
+        for (const auto& fileName : qAsConst(replaced))
+        {
+            writeFile(fileName, results[fileName].originalContent);
+        }
+        for (auto it = results.cbegin(); it != results.cend(); ++it)
+        {
+            if (!replaced.contains(it.key()))
+                QFile::remove(it->tempFileName);
+        }
+        return false;
+    }
+
+    d->operations.clear();
+    return true;
+}
+
+void Transaction::clear()
+{
+    Q_D(Transaction);
+    d->operations.clear();
+}
+
+} // namespace cmle
@@ -0,0 +1,44 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QScopedPointer>
+#include <QStringList>
+#include <functional>
+
+namespace cmle {
+
+class AsyncFileLoaderPrivate;
+
+// Loads many files at once. On Linux the reads are submitted through io_uring if the library was built with liburing
+// support and the kernel allows it, otherwise the files are read by a pool of worker threads.
+//
+// The handler is called for every file as soon as its content has been read, so parsing a file overlaps with reading
+// the remaining ones. It runs on worker threads and may be called concurrently for different files.
+class AsyncFileLoader
+{
+public:
+    using Handler = std::function<void(const QString& fileName, const QByteArray& content, bool success)>;
+
+public:
+    AsyncFileLoader();
+    ~AsyncFileLoader();
+
+    // Maximum number of reads in flight and of concurrently running handlers. Defaults to the number of CPU cores
+    // for the handlers and 64 for io_uring reads.
+    void setMaxThreadCount(int maxThreadCount);
+    void setMaxConcurrentReads(int maxConcurrentReads);
+
+    // Returns after the handler was called for all files.
+    void load(const QStringList& fileNames, const Handler& handler);
+
+private:
+    QScopedPointer<AsyncFileLoaderPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(AsyncFileLoader)
+
+    Q_DISABLE_COPY_MOVE(AsyncFileLoader)
+};
+
+} // namespace cmle
@@ -0,0 +1,32 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "FileBuffer.h"
+#include <QScopedPointer>
+
+namespace cmle {
+
+class ByteArrayFileBufferPrivate;
+
+class ByteArrayFileBuffer : public FileBuffer
+{
+public:
+    ByteArrayFileBuffer();
+    ByteArrayFileBuffer(const QByteArray& content);
+    ~ByteArrayFileBuffer() override;
+
+    QString fileName() const override;
+
+    QByteArray content() const override;
+    void setContent(const QByteArray& content) override;
+
+private:
+    QScopedPointer<ByteArrayFileBufferPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(ByteArrayFileBuffer)
+
+    Q_DISABLE_COPY_MOVE(ByteArrayFileBuffer)
+};
+
+} // namespace cmle
@@ -6,6 +6,10 @@
 #include <QMimeType>
 #include <QObject>
 #include <QPoint>
+#include <QRegularExpression>
+#include <QStringList>
+#include <functional>
+#include <memory>
 
 namespace cmle {
 
@@ -17,6 +21,7 @@ enum class SortSectionPolicy
 
 class FileBuffer;
 class CMakeListsFilePrivate;
+class CMakeListsFileSnapshotData;
 
 class CMakeListsFile : public QObject
 {
@@ -30,8 +35,57 @@ public:
         QString newContent;
     };
 
+    struct SourcesSection
+    {
+        QString name;
+        QStringList fileNames;
+    };
+
+    // A function defining sources of a target (e.g. add_library() or target_sources()). The lines refer to the
+    // original file content.
+    struct SourcesBlock
+    {
+        QString functionName;
+        QString target;
+        int startLine;
+        int endLine;
+        QList<SourcesSection> sections;
+    };
+
+    // Immutable state of all source lists of a file. Taking a snapshot is O(1), the data is shared with the file. An
+    // edit after that copies the edited function without its file lists and, of the edited section, the list of chunk
+    // pointers and the chunk of about 64 file names it changes. Snapshots can be taken and queried from any thread
+    // while another one edits the file.
+    class Snapshot
+    {
+    public:
+        Snapshot();
+        Snapshot(const Snapshot& other);
+        Snapshot& operator=(const Snapshot& other);
+        ~Snapshot();
+
+        bool isNull() const;
+
+        bool hasChangedBlocks() const;
+        QStringList targets() const;
+        QStringList sourceFiles(const QString& target, const QString& sectionName = {}) const;
+        QStringList targetsOfSourceFile(const QString& fileName) const;
+        QList<SourcesBlock> sourcesBlocks() const;
+        QStringList subdirectories() const;
+
+    private:
+        Snapshot(std::shared_ptr<const CMakeListsFileSnapshotData> data);
+
+        std::shared_ptr<const CMakeListsFileSnapshotData> d;
+
+        friend class CMakeListsFile;
+    };
+
 public:
     CMakeListsFile(const QByteArray& fileBuffer, QObject* parent = nullptr);
+    // The content is shared with the buffer if possible (see FileBuffer), the buffer may be destroyed before this
+    // object.
+    CMakeListsFile(const FileBuffer& fileBuffer, QObject* parent = nullptr);
     ~CMakeListsFile() override;
 
     void setSortSectionPolicy(SortSectionPolicy sortSectionPolicy);
@@ -43,8 +97,52 @@ public:
     bool renameSourceFile(const QString& target, const QString& oldFileName, const QString& newFileName);
     bool removeSourceFile(const QString& target, const QString& fileName);
 
+    // Bulk edits of the sources of target, or of all targets if target is empty. Every source list is visited once and
+    // every changed section is sorted once (with SortSectionPolicy::Sort). They return the number of changed files.
+    // Patterns match anywhere in the file name unless anchored, use QRegularExpression::fromWildcard() for globs.
+    qsizetype removeSourceFiles(const QString& target, const QRegularExpression& pattern);
+    // E.g. renameSourceFilePrefix({}, "src/old/", "src/new/") for a directory move
+    qsizetype renameSourceFilePrefix(const QString& target, const QString& oldPrefix, const QString& newPrefix);
+    // Replaces all matches of pattern in every file name, see QString::replace()
+    qsizetype replaceSourceFiles(const QString& target, const QRegularExpression& pattern, const QString& replacement);
+    // edit may change the file name or return false to remove the file.
+    qsizetype editSourceFiles(const QString& target, const std::function<bool(QString& fileName)>& edit);
+
+    // Thread-safe, like all queries below. Edits have to be done by one thread at a time.
+    Snapshot snapshot() const;
+    // Returns to the state of the snapshot, which has to be taken from this file. Restoring can be undone.
+    void restore(const Snapshot& snapshot);
+
+    // Maximum number of steps that can be undone, -1 for no limit. The default of 0 records no history, so files that
+    // are only edited and written, like in the command line interface, do not keep old states alive. Lowering the
+    // limit drops the oldest steps.
+    void setUndoLimit(int undoLimit);
+    int undoLimit() const;
+
+    // Every successful add, rename, remove or restore can be undone, up to undoLimit() steps. The steps share
+    // everything they do not change (like snapshots), undo and redo only copy the list of functions.
+    bool canUndo() const;
+    bool canRedo() const;
+    bool undo();
+    bool redo();
+    void clearUndoStack();
+
+    QStringList targets() const;
+    QStringList sourceFiles(const QString& target, const QString& sectionName = {}) const;
+    QStringList targetsOfSourceFile(const QString& fileName) const;
+    QList<SourcesBlock> sourcesBlocks() const;
+
+    // Source directories of all add_subdirectory() calls as written in the file. Directories containing variable
+    // references are skipped.
+    QStringList subdirectories() const;
+
     QByteArray write();
 
+signals:
+    // Emitted after the source files of a target were changed by one of the edit functions above. Not emitted by
+    // restore(), undo() and redo().
+    void sourceFilesChanged(const QString& target);
+
 private:
     QScopedPointer<CMakeListsFilePrivate> d_ptr;
     Q_DECLARE_PRIVATE(CMakeListsFile)
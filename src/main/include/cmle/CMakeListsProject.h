@@ -0,0 +1,86 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+
+namespace cmle {
+
+class CMakeListsFile;
+class CMakeListsProjectPrivate;
+
+enum class SubdirectoryDiscovery
+{
+    // follow add_subdirectory() calls with literal paths
+    AddSubdirectory,
+    // additionally pick up every CMakeLists.txt below the root directory (build trees are skipped)
+    AddSubdirectoryAndGlob
+};
+
+// All CMakeLists files of a source tree, starting at the root CMakeLists.txt. The files are loaded and parsed in
+// parallel. A global index tells which files and functions define or extend a target.
+//
+// With a cache file set, the index and the subdirectories of every file are stored on disk after loading. Files whose
+// size and modification time (or content) still match the cache are not parsed on the next load(), file() parses them
+// on first access instead.
+//
+// While watching, a file changed on disk is reparsed alone, the target index is updated for this file only and the
+// affected targets are reported by targetsChanged().
+class CMakeListsProject : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct TargetLocation
+    {
+        QString fileName;
+        QString functionName;
+        int startLine;
+        int endLine;
+    };
+
+public:
+    CMakeListsProject(QObject* parent = nullptr);
+    ~CMakeListsProject() override;
+
+    void setSubdirectoryDiscovery(SubdirectoryDiscovery subdirectoryDiscovery);
+
+    QString cacheFileName() const;
+    void setCacheFileName(const QString& cacheFileName);
+
+    bool isWatching() const;
+    void setWatching(bool watching);
+
+    // Returns false if any of the discovered files could not be loaded. All other files are available anyway.
+    bool load(const QString& rootFileName);
+
+    QString rootFileName() const;
+
+    // Absolute file names in discovery order
+    QStringList fileNames() const;
+    // Returns a null pointer if the file is not part of the project or could not be parsed.
+    QSharedPointer<CMakeListsFile> file(const QString& fileName) const;
+
+    QStringList targets() const;
+    QList<TargetLocation> targetLocations(const QString& target) const;
+
+    // Has to be called after changing the target definitions of a file.
+    void updateTargetIndex();
+
+signals:
+    // Emitted after a watched file was reparsed or removed from the project. file() returns a new object afterwards,
+    // the old one is not updated.
+    void fileChanged(const QString& fileName);
+    void targetsChanged(const QStringList& targets);
+
+private:
+    QScopedPointer<CMakeListsProjectPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(CMakeListsProject)
+
+    Q_DISABLE_COPY_MOVE(CMakeListsProject)
+};
+
+} // namespace cmle
@@ -0,0 +1,33 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <memory>
+
+namespace cmle {
+
+// Source of the raw content of a CMakeLists file.
+//
+// Implementations may return a QByteArray created with QByteArray::fromRawData() from content(), which allows reading
+// memory mapped or otherwise externally owned data without copying it. A CMakeListsFile reads its content in place:
+// heap content is shared, raw data is kept alive by contentOwner() or copied if there is none. Either way the buffer
+// does not have to outlive the file.
+class FileBuffer
+{
+public:
+    virtual ~FileBuffer() = default;
+
+    virtual QString fileName() const = 0;
+
+    virtual QByteArray content() const = 0;
+    virtual void setContent(const QByteArray& content) = 0;
+
+    // Keeps the memory of the current content() valid and unchanged for as long as it is held, null if the content
+    // is on the heap or cannot be kept alive.
+    virtual std::shared_ptr<const void> contentOwner() const { return {}; }
+};
+
+} // namespace cmle
@@ -0,0 +1,44 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "FileBuffer.h"
+#include <QScopedPointer>
+
+namespace cmle {
+
+class MappedFileBufferPrivate;
+
+// Memory maps a file read-only. content() refers to the mapping directly, so it is only valid as long as the buffer
+// lives and the file is not truncated by someone else. setContent() moves the buffer content to the heap, the mapping
+// is kept until the next load() or destruction of the buffer. Use StandardFileBuffer to write the result back.
+//
+// A CMakeListsFile created from the buffer reads the mapping without copying it and keeps it (and the open file)
+// alive through contentOwner() until the file, its snapshots and undo steps are destroyed.
+class MappedFileBuffer : public FileBuffer
+{
+public:
+    MappedFileBuffer();
+    MappedFileBuffer(const QString& fileName);
+    ~MappedFileBuffer() override;
+
+    bool isDirty() const;
+
+    QString fileName() const override;
+    void setFileName(const QString& fileName);
+
+    bool load();
+
+    QByteArray content() const override;
+    void setContent(const QByteArray& content) override;
+    std::shared_ptr<const void> contentOwner() const override;
+
+private:
+    QScopedPointer<MappedFileBufferPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(MappedFileBuffer)
+
+    Q_DISABLE_COPY_MOVE(MappedFileBuffer)
+};
+
+} // namespace cmle
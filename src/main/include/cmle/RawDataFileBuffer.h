@@ -0,0 +1,35 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "FileBuffer.h"
+#include <QByteArrayView>
+#include <QScopedPointer>
+
+namespace cmle {
+
+class RawDataFileBufferPrivate;
+
+// Wraps memory owned by the caller without copying it. The memory must stay valid and unchanged as long as the buffer
+// is alive, a CMakeListsFile created from it takes its own copy.
+class RawDataFileBuffer : public FileBuffer
+{
+public:
+    RawDataFileBuffer();
+    RawDataFileBuffer(QByteArrayView data, const QString& fileName = {});
+    ~RawDataFileBuffer() override;
+
+    QString fileName() const override;
+
+    QByteArray content() const override;
+    void setContent(const QByteArray& content) override;
+
+private:
+    QScopedPointer<RawDataFileBufferPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(RawDataFileBuffer)
+
+    Q_DISABLE_COPY_MOVE(RawDataFileBuffer)
+};
+
+} // namespace cmle
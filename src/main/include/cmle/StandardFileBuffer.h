@@ -0,0 +1,48 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "FileBuffer.h"
+#include <QScopedPointer>
+
+namespace cmle {
+
+enum class SavePolicy
+{
+    // Always rewrite the file, even if the content did not change.
+    Overwrite,
+    // Leave the file (and its modification time) untouched if the on-disk content equals the buffer.
+    SkipUnchanged
+};
+
+class StandardFileBufferPrivate;
+
+class StandardFileBuffer : public FileBuffer
+{
+public:
+    StandardFileBuffer();
+    StandardFileBuffer(const QString& fileName);
+    ~StandardFileBuffer() override;
+
+    void setSavePolicy(SavePolicy savePolicy);
+
+    bool isDirty() const;
+
+    QString fileName() const override;
+    void setFileName(const QString& fileName);
+
+    bool load();
+    bool save();
+
+    QByteArray content() const override;
+    void setContent(const QByteArray& content) override;
+
+private:
+    QScopedPointer<StandardFileBufferPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(StandardFileBuffer)
+
+    Q_DISABLE_COPY_MOVE(StandardFileBuffer)
+};
+
+} // namespace cmle
@@ -0,0 +1,47 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// Phase level instrumentation of parsing, editing and writing. Tracing is off by default and costs one atomic load per
+// scope then. Setting the environment variable CMLE_TRACE to a file name enables it at startup, the trace is written to
+// that file by flush().
+namespace cmle::trace {
+
+bool isEnabled();
+void setEnabled(bool enabled);
+
+void clear();
+
+// Writes the recorded events to the file named by CMLE_TRACE, does nothing if it is not set. Called automatically when
+// the QCoreApplication is destroyed, programs without one have to call it before they exit.
+bool flush();
+
+// Recorded events in the Chrome trace-event format, which can be loaded by chrome://tracing or Perfetto.
+QByteArray toChromeTrace();
+bool writeChromeTrace(const QString& fileName);
+
+// Records the value of a counter, name has to be a string literal.
+void counter(const char* name, qint64 value);
+
+// Records the time between construction and destruction as complete event, name has to be a string literal.
+class Scope
+{
+public:
+    explicit Scope(const char* name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name_;
+    qint64 start_;
+};
+
+} // namespace cmle::trace
+
+#define CMLE_TRACE_SCOPE(name) const ::cmle::trace::Scope cmleTraceScope{name}
@@ -0,0 +1,56 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "CMakeListsFile.h"
+#include <QScopedPointer>
+
+namespace cmle {
+
+class TransactionPrivate;
+
+// Source list edits spanning any number of CMakeLists files, which are written all or nothing.
+//
+// commit() loads the affected files in parallel, applies the operations of every file in the order they were added
+// and fails without touching any file if one of them fails. Otherwise the new content of each changed file is written
+// once to a uniquely named temporary file next to it and synced, then all temporary files are renamed over the
+// originals. If a rename fails, the files replaced so far are restored from their original content and the remaining
+// temporary files are removed.
+//
+// Each single file is always replaced atomically, but the all or nothing guarantee across files does not survive a
+// crash: if the process dies while the files are renamed, some files have the new content and the others the old one,
+// and temporary files named like <file>.cmle-XXXXXX may be left behind.
+class Transaction
+{
+public:
+    Transaction();
+    ~Transaction();
+
+    void setSortSectionPolicy(SortSectionPolicy sortSectionPolicy);
+
+    void addSourceFile(const QString& cmakeListsFile, const QString& target, const QString& fileName,
+                       const QMimeType& mimeType = {});
+    void renameSourceFile(const QString& cmakeListsFile, const QString& target, const QString& oldFileName,
+                          const QString& newFileName);
+    void removeSourceFile(const QString& cmakeListsFile, const QString& target, const QString& fileName);
+
+    // Removes the file from one target and adds it to another one, possibly defined in a different file.
+    void moveSourceFile(const QString& fromCMakeListsFile, const QString& fromTarget, const QString& toCMakeListsFile,
+                        const QString& toTarget, const QString& fileName, const QMimeType& mimeType = {});
+
+    // CMakeLists files with pending operations
+    QStringList fileNames() const;
+
+    // The pending operations are kept if the commit fails.
+    bool commit();
+    void clear();
+
+private:
+    QScopedPointer<TransactionPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(Transaction)
+
+    Q_DISABLE_COPY_MOVE(Transaction)
+};
+
+} // namespace cmle
@@ -0,0 +1,196 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <cmle/Trace.h>
+
+#include <cmle/core/Trace.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+
+namespace cmle::trace {
+
+namespace {
+
+const QLoggingCategory CMAKE{"com.va.cmakelistsedit"};
+
+struct Event
+{
+    const char* name;
+    char phase;
+    quintptr threadId;
+    qint64 timestamp;
+    // duration for complete events, value for counters
+    qint64 value;
+};
+
+const core::trace::Hooks& coreHooks();
+
+struct State
+{
+    State()
+    {
+        timer.start();
+
+        traceFileName = qEnvironmentVariable("CMLE_TRACE");
+        if (!traceFileName.isEmpty())
+        {
+            enabled = true;
+            qAddPostRoutine([]() { flush(); });
+        }
+
+        // CMakeListsFile records a scope of its own before it parses with the core, so the hooks are in place before
+        // the core reports anything
+        core::trace::setHooks(&coreHooks());
+    }
+
+    static State& state()
+    {
+        // never destroyed, events may still be recorded while static objects are destroyed
+        static State* instance = new State;
+        return *instance;
+    }
+
+    void add(const Event& event)
+    {
+        QMutexLocker lock{&mutex};
+        events << event;
+    }
+
+    std::atomic_bool enabled{false};
+    QElapsedTimer timer{};
+    QString traceFileName{};
+    QMutex mutex{};
+    QList<Event> events{};
+};
+
+qint64 now()
+{
+    return State::state().timer.nsecsElapsed();
+}
+
+quintptr currentThreadId()
+{
+    return reinterpret_cast<quintptr>(QThread::currentThreadId());
+}
+
+// forwards the phases and counters of the Qt free core
+const core::trace::Hooks& coreHooks()
+{
+    static const core::trace::Hooks hooks{
+        []() -> int64_t { return isEnabled() ? now() : -1; },
+        [](const char* name, int64_t start) {
+            State::state().add({name, 'X', currentThreadId(), start, now() - start});
+        },
+        [](const char* name, int64_t value) { counter(name, value); },
+    };
+    return hooks;
+}
+
+} // namespace
+
+bool isEnabled()
+{
+    return State::state().enabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled)
+{
+    State::state().enabled = enabled;
+}
+
+void clear()
+{
+    auto& state = State::state();
+    QMutexLocker lock{&state.mutex};
+    state.events.clear();
+}
+
+QByteArray toChromeTrace()
+{
+    auto& state = State::state();
+
+    QList<Event> events;
+    {
+        QMutexLocker lock{&state.mutex};
+        events = state.events;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    for (const auto& event : qAsConst(events))
+    {
+        // timestamps and durations are microseconds
+        QJsonObject object{
+            {QLatin1String("name"), QLatin1String(event.name)},
+            {QLatin1String("ph"), QString{QLatin1Char(event.phase)}},
+            {QLatin1String("pid"), pid},
+            {QLatin1String("tid"), static_cast<qint64>(event.threadId)},
+            {QLatin1String("ts"), static_cast<double>(event.timestamp) / 1000.0},
+        };
+
+        if (event.phase == 'X')
+            object.insert(QLatin1String("dur"), static_cast<double>(event.value) / 1000.0);
+        else
+            object.insert(QLatin1String("args"), QJsonObject{{QLatin1String("value"), event.value}});
+
+        traceEvents << object;
+    }
+
+    return QJsonDocument{QJsonObject{{QLatin1String("traceEvents"), traceEvents}}}.toJson(QJsonDocument::Compact);
+}
+
+bool writeChromeTrace(const QString& fileName)
+{
+    QFile file{fileName};
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        qCWarning(CMAKE) << "Could not open trace file" << fileName;
+        return false;
+    }
+
+    const QByteArray data = toChromeTrace();
+    return file.write(data) == data.size();
+}
+
+bool flush()
+{
+    const auto& fileName = State::state().traceFileName;
+    if (fileName.isEmpty())
+        return true;
+    return writeChromeTrace(fileName);
+}
+
+void counter(const char* name, qint64 value)
+{
+    if (!isEnabled())
+        return;
+
+    State::state().add({name, 'C', currentThreadId(), now(), value});
+}
+
+Scope::Scope(const char* name) :
+    name_{name},
+    start_{isEnabled() ? now() : -1}
+{
+}
+
+Scope::~Scope()
+{
+    if (start_ < 0)
+        return;
+
+    const qint64 end = now();
+    State::state().add({name_, 'X', currentThreadId(), start_, end - start_});
+}
+
+} // namespace cmle::trace
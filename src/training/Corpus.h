@@ -0,0 +1,35 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QByteArray>
+
+namespace cmle::training {
+
+// Deterministic CMakeLists content with one add_library() and one target_sources() call per target. 600 targets with 25
+// files per function make about 1 MB.
+inline QByteArray generateCorpus(int targets, int filesPerFunction)
+{
+    QByteArray output;
+    for (int t = 0; t < targets; ++t)
+    {
+        const QByteArray target = "target" + QByteArray::number(t);
+        const QByteArray dir = "src/module" + QByteArray::number(t) + "/";
+
+        output += "add_library(" + target + " STATIC\n";
+        for (int f = 0; f < filesPerFunction; ++f)
+        {
+            output += "    " + dir + "SourceFile" + QByteArray::number(f) + ".cpp\n";
+        }
+        output += ")\n\ntarget_sources(" + target + " PRIVATE\n";
+        for (int f = 0; f < filesPerFunction; ++f)
+        {
+            output += "    " + dir + "HeaderFile" + QByteArray::number(f) + ".h\n";
+        }
+        output += ")\n\n";
+    }
+    return output;
+}
+
+} // namespace cmle::training
@@ -0,0 +1,102 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Corpus.h"
+#include <cmle/CMakeListsFile.h>
+#include <QMimeDatabase>
+#include <QRegularExpression>
+#include <iostream>
+
+// Training workload of the instrumented stage of a profile guided build. It should resemble real use, the profile
+// decides which branches the optimized stage lays out as hot.
+
+namespace {
+
+// the corpus only consists of unquoted arguments, this covers the rest of the lexer
+const char* const kSyntaxSample = R"cmake(# comment line
+cmake_minimum_required(VERSION 3.16)
+project(Training LANGUAGES CXX) # trailing comment
+
+#[[ bracket
+    comment ]]
+set(SOURCES "quoted file.cpp" [=[bracket;argument.cpp]=] ${VARIABLE}/Escaped\ Name.cpp)
+
+add_executable(training
+    Main.cpp
+    "Quoted.cpp"
+    ${SOURCES}
+)
+
+if(WIN32)
+    target_sources(training PRIVATE
+        Windows.cpp
+    )
+else()
+    target_sources(training PRIVATE Unix.cpp)
+endif()
+
+target_sources(training
+    PRIVATE
+        Private.cpp
+        Private.h
+    PUBLIC
+        Public.h
+)
+)cmake";
+
+void train(const QByteArray& content, int targets, const QMimeType& sourceType, const QMimeType& headerType)
+{
+    for (auto policy : {cmle::SortSectionPolicy::NoSort, cmle::SortSectionPolicy::Sort})
+    {
+        cmle::CMakeListsFile file{content};
+        if (!file.isLoaded())
+        {
+            std::cerr << "Could not parse training content" << std::endl;
+            continue;
+        }
+
+        file.setSortSectionPolicy(policy);
+
+        for (int t = 0; t < targets; t += 3)
+        {
+            const auto target = QStringLiteral("target%1").arg(t);
+            const auto dir = QStringLiteral("src/module%1/").arg(t);
+
+            for (int f = 0; f < 5; ++f)
+            {
+                file.addSourceFile(target, dir + QStringLiteral("Added%1.cpp").arg(f), sourceType);
+                file.addSourceFile(target, dir + QStringLiteral("Added%1.h").arg(f), headerType);
+            }
+            file.renameSourceFile(target, dir + QStringLiteral("SourceFile1.cpp"), dir + QStringLiteral("Renamed.cpp"));
+            file.removeSourceFile(target, dir + QStringLiteral("SourceFile2.cpp"));
+        }
+
+        file.removeSourceFiles({}, QRegularExpression{QStringLiteral("HeaderFile1[0-9]\\.h$")});
+        file.renameSourceFilePrefix(QStringLiteral("target1"), QStringLiteral("src/module1/"), QStringLiteral("lib/"));
+
+        file.addSourceFile(QStringLiteral("training"), QStringLiteral("Added.cpp"), sourceType);
+
+        file.targets();
+        file.write();
+    }
+}
+
+} // namespace
+
+int main()
+{
+    const QMimeDatabase mimeDatabase;
+    const auto sourceType = mimeDatabase.mimeTypeForName(QStringLiteral("text/x-c++src"));
+    const auto headerType = mimeDatabase.mimeTypeForName(QStringLiteral("text/x-c++hdr"));
+
+    // a mix of typical and large files
+    train(cmle::training::generateCorpus(20, 10), 20, sourceType, headerType);
+    train(cmle::training::generateCorpus(600, 25), 600, sourceType, headerType);
+
+    for (int i = 0; i < 50; ++i)
+    {
+        train(kSyntaxSample, 0, sourceType, headerType);
+    }
+
+    return 0;
+}
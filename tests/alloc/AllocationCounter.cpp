@@ -0,0 +1,242 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "AllocationCounter.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <new>
+
+namespace {
+
+// plain data, so accessing them never allocates
+thread_local qint64 allocations = 0;
+thread_local qint64 bytes = 0;
+
+inline void count(std::size_t size)
+{
+    ++allocations;
+    bytes += static_cast<qint64>(size);
+}
+
+} // namespace
+
+#if defined(__GLIBC__)
+
+// Calls from the program and other shared libraries reach malloc() and friends through the dynamic linker, so defining
+// them here catches those. Whether the allocations glibc makes for itself (e.g. in strdup()) are caught depends on how
+// it was built, tests must not rely on them. operator new is replaced as well, so the count does not depend on how
+// libstdc++ reaches the allocator. All replacements call the __libc_ functions, every allocation is counted once.
+extern "C" {
+
+void* __libc_malloc(std::size_t size) noexcept;
+void* __libc_calloc(std::size_t n, std::size_t size) noexcept;
+void* __libc_realloc(void* ptr, std::size_t size) noexcept;
+void* __libc_memalign(std::size_t alignment, std::size_t size) noexcept;
+void __libc_free(void* ptr) noexcept;
+
+void* malloc(std::size_t size) noexcept
+{
+    count(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t n, std::size_t size) noexcept
+{
+    count(n * size);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, std::size_t size) noexcept
+{
+    count(size);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) noexcept
+{
+    count(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+{
+    count(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, std::size_t alignment, std::size_t size) noexcept
+{
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+
+    count(size);
+    void* output = __libc_memalign(alignment, size);
+    if (!output)
+        return ENOMEM;
+    *ptr = output;
+    return 0;
+}
+
+void free(void* ptr) noexcept
+{
+    __libc_free(ptr);
+}
+
+} // extern "C"
+
+namespace {
+
+void* allocate(std::size_t size)
+{
+    count(size);
+    // operator new(0) must return a unique pointer
+    if (void* output = __libc_malloc(size != 0 ? size : 1))
+        return output;
+    throw std::bad_alloc{};
+}
+
+void* allocate(std::size_t size, std::align_val_t alignment)
+{
+    count(size);
+    if (void* output = __libc_memalign(static_cast<std::size_t>(alignment), size != 0 ? size : 1))
+        return output;
+    throw std::bad_alloc{};
+}
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    count(size);
+    return __libc_malloc(size != 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    count(size);
+    return __libc_malloc(size != 0 ? size : 1);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocate(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    count(size);
+    return __libc_memalign(static_cast<std::size_t>(alignment), size != 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    count(size);
+    return __libc_memalign(static_cast<std::size_t>(alignment), size != 0 ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    __libc_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    __libc_free(ptr);
+}
+
+#endif
+
+namespace cmle::test {
+
+bool isCountingSupported()
+{
+#if defined(__GLIBC__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationCount currentAllocationCount()
+{
+    return {allocations, bytes};
+}
+
+AllocationScope::AllocationScope() :
+    start_{currentAllocationCount()}
+{
+}
+
+AllocationCount AllocationScope::count() const
+{
+    const auto now = currentAllocationCount();
+    return {now.allocations - start_.allocations, now.bytes - start_.bytes};
+}
+
+} // namespace cmle::test
@@ -0,0 +1,35 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QtGlobal>
+
+// Counts heap allocations of the current thread. Linking this library into a test replaces malloc(), operator new and
+// friends, so it must not be combined with sanitizers or other allocator replacements. Only glibc allows hooking
+// malloc() like this, the counts stay 0 everywhere else.
+namespace cmle::test {
+
+bool isCountingSupported();
+
+struct AllocationCount
+{
+    qint64 allocations;
+    qint64 bytes;
+};
+
+AllocationCount currentAllocationCount();
+
+// Allocations made by the current thread since construction
+class AllocationScope
+{
+public:
+    AllocationScope();
+
+    AllocationCount count() const;
+
+private:
+    AllocationCount start_;
+};
+
+} // namespace cmle::test
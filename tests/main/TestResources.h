@@ -0,0 +1,28 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+// Access to the files in tests/res, shared by all tests.
+namespace cmle::test {
+
+inline QString resourceFile(const char* name)
+{
+    return QLatin1String(RESOURCE_DIR) + QLatin1Char('/') + QLatin1String(name);
+}
+
+// Aborts the test if the file cannot be read, so a missing file never passes as empty content. Not an assertion, those
+// are compiled out in release builds.
+inline QByteArray fileData(const QString& fileName)
+{
+    QFile f(fileName);
+    if (!f.open(QFile::ReadOnly))
+        qFatal("Could not open %s: %s", qPrintable(fileName), qPrintable(f.errorString()));
+    return f.readAll();
+}
+
+} // namespace cmle::test
@@ -0,0 +1,150 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "../alloc/AllocationCounter.h"
+#include "training/Corpus.h"
+#include <cmle/CMakeListsFile.h>
+#include <cmle/core/ListFile.h>
+#include <QtTest>
+
+namespace {
+
+constexpr int kTargets = 600;
+constexpr int kFilesPerFunction = 25;
+
+// target, STATIC/PRIVATE and the file names of both functions
+constexpr qint64 kArguments = kTargets * 2 * (kFilesPerFunction + 2);
+
+// An edit copies the changed function without its file lists and one chunk of about 64 file names, independent of the
+// size of the file and section.
+constexpr qint64 kAllocationsPerEdit = 400;
+
+constexpr int kLargeSectionFiles = 5000;
+
+QByteArray formatCount(const cmle::test::AllocationCount& count)
+{
+    return QByteArray::number(count.allocations) + " allocations, " + QByteArray::number(count.bytes) + " bytes";
+}
+
+} // namespace
+
+// Parsing has a generous upper bound per function argument, every edit a small budget independent of the file size and
+// writing allocates once. They are meant to catch regressions like a copy per token, a copy of a whole section per edit
+// or a quadratic rebuild, lower them when the allocation behaviour improves.
+class AllocationsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        if (!cmle::test::isCountingSupported())
+            QSKIP("Allocations are only counted with glibc");
+
+        data = cmle::training::generateCorpus(kTargets, kFilesPerFunction);
+        QVERIFY(data.size() > 1000 * 1000);
+        cppSrcMimeType = QMimeDatabase().mimeTypeForName(QStringLiteral("text/x-c++src"));
+    }
+
+    void countingWorks()
+    {
+        cmle::test::AllocationScope scope;
+        QByteArray buffer(1024, 'x');
+        QVERIFY(scope.count().allocations >= 1);
+        QVERIFY(scope.count().bytes >= buffer.size());
+    }
+
+    void parse()
+    {
+        cmle::test::AllocationScope scope;
+        cmle::CMakeListsFile file{data};
+        const auto count = scope.count();
+
+        QVERIFY(file.isLoaded());
+        qInfo("parse: %s", formatCount(count).constData());
+        QVERIFY2(count.allocations < 16 * kArguments, formatCount(count).constData());
+    }
+
+    void editAndWrite()
+    {
+        cmle::CMakeListsFile file{data};
+        QVERIFY(file.isLoaded());
+
+        cmle::test::AllocationScope editScope;
+        for (int t = 0; t < 100; ++t)
+        {
+            QVERIFY(file.addSourceFile(QStringLiteral("target%1").arg(t), QStringLiteral("src/New.cpp"),
+                                       cppSrcMimeType));
+        }
+        const auto editCount = editScope.count();
+        qInfo("edit: %s", formatCount(editCount).constData());
+        QVERIFY2(editCount.allocations < 100 * kAllocationsPerEdit, formatCount(editCount).constData());
+
+        cmle::test::AllocationScope writeScope;
+        const QByteArray output = file.write();
+        const auto writeCount = writeScope.count();
+
+        QVERIFY(output.size() > data.size());
+        qInfo("write: %s", formatCount(writeCount).constData());
+        QCOMPARE(writeCount.allocations, qint64{1});
+    }
+
+    void coreWrite()
+    {
+        cmle::core::ListFile file{std::string{data.constData(), static_cast<size_t>(data.size())}};
+        for (int t = 0; t < 100; ++t)
+        {
+            QVERIFY(file.addSourceFile("target" + std::to_string(t), "src/New.cpp"));
+        }
+
+        // the size is measured before writing, so the output grows exactly once
+        std::string output;
+        cmle::test::AllocationScope scope;
+        file.write(output);
+        const auto count = scope.count();
+
+        QCOMPARE(output.size(), file.size());
+        QCOMPARE(count.allocations, qint64{1});
+    }
+
+    void editLargeSection()
+    {
+        // Every edit is kept as undo step and in a snapshot, the section must still not be copied as a whole
+        QByteArray content = "add_library(big STATIC\n";
+        for (int i = 0; i < kLargeSectionFiles; ++i)
+        {
+            content += "    src/generated/file" + QByteArray::number(10000 + 2 * i) + ".cpp\n";
+        }
+        content += ")\n";
+
+        cmle::CMakeListsFile file{content};
+        QVERIFY(file.isLoaded());
+        file.setSortSectionPolicy(cmle::SortSectionPolicy::Sort);
+        file.setUndoLimit(-1);
+        // the first edit checks the order of the whole section
+        QVERIFY(file.addSourceFile(QStringLiteral("big"), QStringLiteral("src/generated/file0.cpp"), cppSrcMimeType));
+        auto snapshot = file.snapshot();
+
+        cmle::test::AllocationScope scope;
+        for (int i = 0; i < 100; ++i)
+        {
+            // spread over the section, between the existing files
+            const int index = (i * 47) % kLargeSectionFiles;
+            const QString fileName = QStringLiteral("src/generated/file%1.cpp").arg(10001 + 2 * index);
+            QVERIFY(file.addSourceFile(QStringLiteral("big"), fileName, cppSrcMimeType));
+            snapshot = file.snapshot();
+        }
+        const auto count = scope.count();
+
+        QCOMPARE(snapshot.sourceFiles(QStringLiteral("big")).size(), qsizetype{kLargeSectionFiles + 101});
+        qInfo("edit large section: %s", formatCount(count).constData());
+        QVERIFY2(count.allocations < 100 * kAllocationsPerEdit, formatCount(count).constData());
+    }
+
+private:
+    QByteArray data;
+    QMimeType cppSrcMimeType;
+};
+
+#include "test_Allocations.moc"
+QTEST_MAIN(AllocationsTest)
@@ -0,0 +1,163 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "TestResources.h"
+#include <cmle/cmle.h>
+#include <QtTest>
+
+namespace {
+
+using cmle::test::fileData;
+using cmle::test::resourceFile;
+
+// splits the NUL terminated strings of cmle_query()
+QList<QByteArray> entries(const char* buffer, size_t length)
+{
+    QList<QByteArray> output;
+    for (size_t pos = 0; pos < length; pos += static_cast<size_t>(output.last().size()) + 1)
+    {
+        output << QByteArray{buffer + pos};
+    }
+    return output;
+}
+
+} // namespace
+
+class CApiTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void openErrors()
+    {
+        cmle_file* file{};
+        QCOMPARE(cmle_open(qPrintable(resourceFile("does_not_exist.cmake")), &file), CMLE_ERROR_IO);
+        QVERIFY(!file);
+        QCOMPARE(cmle_open(qPrintable(resourceFile("invalid_listsfile.cmake")), &file), CMLE_ERROR_PARSE);
+        QVERIFY(!file);
+        QCOMPARE(cmle_open(nullptr, &file), CMLE_ERROR_INVALID_ARGUMENT);
+    }
+
+    void editAndWrite()
+    {
+        cmle_file* file{};
+        QCOMPARE(cmle_open(qPrintable(resourceFile("two_source_blocks.cmake")), &file), CMLE_OK);
+        QVERIFY(file);
+        QCOMPARE(cmle_has_changes(file), 0);
+
+        QCOMPARE(cmle_remove(file, "main", "does_not_exist.cpp"), CMLE_ERROR_NOT_FOUND);
+        QCOMPARE(cmle_add(file, "unknown", "Atest1.cpp"), CMLE_ERROR_NOT_FOUND);
+        QCOMPARE(cmle_rename(file, "main", "CMakeListsFile.cpp", "Atest1.cpp"), CMLE_OK);
+        QCOMPARE(cmle_has_changes(file), 1);
+
+        const auto expected = fileData(resourceFile("two_source_blocks-rename_top.cmake"));
+
+        size_t length{};
+        QCOMPARE(cmle_write_to(file, nullptr, 0, &length), CMLE_ERROR_BUFFER_TOO_SMALL);
+        QCOMPARE(length, static_cast<size_t>(expected.size()));
+
+        QByteArray buffer(static_cast<qsizetype>(length), '\0');
+        QCOMPARE(cmle_write_to(file, buffer.data(), length, &length), CMLE_OK);
+        QCOMPARE(buffer, expected);
+
+        cmle_close(file);
+    }
+
+    void save()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto fileName = dir.filePath(QStringLiteral("CMakeLists.txt"));
+        QVERIFY(QFile::copy(resourceFile("two_source_blocks.cmake"), fileName));
+
+        // the replacing file gets the permissions of the saved one
+        const QFile::Permissions permissions = QFile::ReadOwner | QFile::WriteOwner | QFile::ReadGroup;
+        QVERIFY(QFile::setPermissions(fileName, permissions));
+
+        cmle_file* file{};
+        QCOMPARE(cmle_open(qPrintable(fileName), &file), CMLE_OK);
+        QCOMPARE(cmle_set_sort(file, 1), CMLE_OK);
+        QCOMPARE(cmle_remove(file, "main", "abc/DefaultFileBuffer.cpp"), CMLE_OK);
+        QCOMPARE(cmle_save(file, nullptr), CMLE_OK);
+        cmle_close(file);
+
+        QCOMPARE(fileData(fileName), fileData(resourceFile("two_source_blocks-remove_bottom_sorted.cmake")));
+#if defined(Q_OS_UNIX)
+        const QFile::Permissions ownerGroupOther = QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner |
+                QFile::ReadGroup | QFile::WriteGroup | QFile::ExeGroup |
+                QFile::ReadOther | QFile::WriteOther | QFile::ExeOther;
+        QCOMPARE(QFile::permissions(fileName) & ownerGroupOther, permissions);
+#endif
+    }
+
+    void saveResetsChanges()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto fileName = dir.filePath(QStringLiteral("CMakeLists.txt"));
+        const auto copyName = dir.filePath(QStringLiteral("copy.txt"));
+        QVERIFY(QFile::copy(resourceFile("two_source_blocks.cmake"), fileName));
+
+        cmle_file* file{};
+        QCOMPARE(cmle_open(qPrintable(fileName), &file), CMLE_OK);
+        QCOMPARE(cmle_rename(file, "main", "CMakeListsFile.cpp", "Atest1.cpp"), CMLE_OK);
+        QCOMPARE(cmle_has_changes(file), 1);
+        QCOMPARE(cmle_save(file, nullptr), CMLE_OK);
+        QCOMPARE(cmle_has_changes(file), 0);
+        QCOMPARE(QDir{dir.path()}.entryList(QDir::Files), QStringList{QStringLiteral("CMakeLists.txt")});
+
+        // the saved state is edited further, a save to another path makes it the opened file
+        QCOMPARE(cmle_remove(file, "main", "Atest1.cpp"), CMLE_OK);
+        QCOMPARE(cmle_save(file, qPrintable(copyName)), CMLE_OK);
+        QCOMPARE(cmle_has_changes(file), 0);
+        QCOMPARE(cmle_add(file, "main", "Atest1.cpp"), CMLE_OK);
+        QCOMPARE(cmle_save(file, nullptr), CMLE_OK);
+        cmle_close(file);
+
+        QCOMPARE(fileData(fileName), fileData(resourceFile("two_source_blocks-rename_top.cmake")));
+        QVERIFY(fileData(copyName) != fileData(fileName));
+    }
+
+    void saveErrors()
+    {
+        const QByteArray content = "add_library(lib STATIC\n    a.cpp\n)\n";
+
+        cmle_file* file{};
+        QCOMPARE(cmle_open_buffer(content.constData(), static_cast<size_t>(content.size()), &file), CMLE_OK);
+        QCOMPARE(cmle_save(file, nullptr), CMLE_ERROR_INVALID_ARGUMENT);
+        QCOMPARE(cmle_add(file, "lib", "b.cpp"), CMLE_OK);
+        QCOMPARE(cmle_save(file, qPrintable(resourceFile("does_not_exist/CMakeLists.txt"))), CMLE_ERROR_IO);
+        QCOMPARE(cmle_has_changes(file), 1);
+        cmle_close(file);
+    }
+
+    void query()
+    {
+        const QByteArray content = "add_library(lib STATIC\n    a.cpp\n    b.cpp\n)\nadd_subdirectory(sub)\n";
+
+        cmle_file* file{};
+        QCOMPARE(cmle_open_buffer(content.constData(), static_cast<size_t>(content.size()), &file), CMLE_OK);
+
+        char buffer[64];
+        size_t length{};
+        QCOMPARE(cmle_query(file, CMLE_QUERY_TARGETS, nullptr, buffer, sizeof(buffer), &length), CMLE_OK);
+        QCOMPARE(entries(buffer, length), QList<QByteArray>{"lib"});
+
+        QCOMPARE(cmle_query(file, CMLE_QUERY_SOURCES, "lib", buffer, sizeof(buffer), &length), CMLE_OK);
+        QCOMPARE(entries(buffer, length), (QList<QByteArray>{"a.cpp", "b.cpp"}));
+
+        QCOMPARE(cmle_query(file, CMLE_QUERY_SUBDIRECTORIES, nullptr, buffer, sizeof(buffer), &length), CMLE_OK);
+        QCOMPARE(entries(buffer, length), QList<QByteArray>{"sub"});
+
+        QCOMPARE(cmle_query(file, CMLE_QUERY_SOURCES, "unknown", buffer, sizeof(buffer), &length),
+                 CMLE_ERROR_NOT_FOUND);
+
+        QCOMPARE(cmle_query(file, CMLE_QUERY_SOURCES, "lib", buffer, 4, &length), CMLE_ERROR_BUFFER_TOO_SMALL);
+        QCOMPARE(length, size_t{12});
+
+        cmle_close(file);
+    }
+};
+
+#include "test_CApi.moc"
+QTEST_MAIN(CApiTest)
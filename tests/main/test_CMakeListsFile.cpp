@@ -1,23 +1,20 @@
 // Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
 // SPDX-License-Identifier: GPL-3.0-only
 
+#include "TestResources.h"
 #include <cmle/CMakeListsFile.h>
+#include <cmle/MappedFileBuffer.h>
+#include <cmle/RawDataFileBuffer.h>
 #include <QtTest>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
 
 namespace {
 
-QByteArray fileData(const QString& fileName)
-{
-    QFile f(fileName);
-    Q_ASSERT(f.open(QFile::ReadOnly));
-    return f.readAll();
-}
-
-QString resourceFile(const char* name)
-{
-    return QLatin1String(RESOURCE_DIR) + QLatin1Char('/') + QLatin1String(name);
-}
+using cmle::test::fileData;
+using cmle::test::resourceFile;
 
 } // namespace
 
@@ -56,6 +53,52 @@ private slots:
         QVERIFY(file.isLoaded());
     }
 
+    void openFileBuffer()
+    {
+        cmle::MappedFileBuffer mappedBuffer{resourceFile("two_source_blocks.cmake")};
+        QVERIFY(mappedBuffer.load());
+        cmle::CMakeListsFile mappedFile{mappedBuffer};
+        QVERIFY(mappedFile.isLoaded());
+        mappedFile.removeSourceFile(QStringLiteral("main"), QStringLiteral("CMakeListsFile.cpp"));
+        QCOMPARE(mappedFile.write(), fileData(resourceFile("two_source_blocks-remove_top.cmake")));
+
+        const QByteArray data = fileData(resourceFile("two_source_blocks.cmake"));
+        cmle::RawDataFileBuffer rawBuffer{data};
+        cmle::CMakeListsFile rawFile{rawBuffer};
+        QVERIFY(rawFile.isLoaded());
+        rawFile.removeSourceFile(QStringLiteral("main"), QStringLiteral("CMakeListsFile.cpp"));
+        QCOMPARE(rawFile.write(), fileData(resourceFile("two_source_blocks-remove_top.cmake")));
+    }
+
+    void outliveFileBuffer()
+    {
+        QByteArray data = fileData(resourceFile("two_source_blocks.cmake"));
+        std::unique_ptr<cmle::CMakeListsFile> file;
+        {
+            cmle::RawDataFileBuffer buffer{data};
+            file = std::make_unique<cmle::CMakeListsFile>(buffer);
+        }
+        data.fill('#');
+        QVERIFY(file->isLoaded());
+        file->removeSourceFile(QStringLiteral("main"), QStringLiteral("CMakeListsFile.cpp"));
+        QCOMPARE(file->write(), fileData(resourceFile("two_source_blocks-remove_top.cmake")));
+    }
+
+    void outliveMappedFileBuffer()
+    {
+        // the file reads the mapping in place and keeps it alive
+        std::unique_ptr<cmle::CMakeListsFile> file;
+        {
+            cmle::MappedFileBuffer buffer{resourceFile("two_source_blocks.cmake")};
+            QVERIFY(buffer.load());
+            QVERIFY(buffer.contentOwner());
+            file = std::make_unique<cmle::CMakeListsFile>(buffer);
+        }
+        QVERIFY(file->isLoaded());
+        file->removeSourceFile(QStringLiteral("main"), QStringLiteral("CMakeListsFile.cpp"));
+        QCOMPARE(file->write(), fileData(resourceFile("two_source_blocks-remove_top.cmake")));
+    }
+
     void openParseError()
     {
         FILE_BUFFER("invalid_listsfile.cmake");
@@ -179,6 +222,259 @@ private slots:
         COMPARE_FILE("two_source_blocks-rename_bottom_sorted.cmake");
     }
 
+    void sortedEdits()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        file.setSortSectionPolicy(cmle::SortSectionPolicy::Sort);
+        QVERIFY(file.addSourceFile(QStringLiteral("main"), QStringLiteral("abc/Atest1.cpp"), cppSrcMimeType));
+        QVERIFY(file.renameSourceFile(QStringLiteral("main"), QStringLiteral("FileBuffer.h"),
+                                      QStringLiteral("abc/Btest1.h")));
+        QVERIFY(file.renameSourceFile(QStringLiteral("main"), QStringLiteral("abc/DefaultFileBuffer.cpp"),
+                                      QStringLiteral("Ctest1.cpp")));
+        QVERIFY(file.removeSourceFile(QStringLiteral("main"), QStringLiteral("FileBuffer.cpp")));
+        QCOMPARE(file.sourceFiles(QStringLiteral("main")).mid(2),
+                 (QStringList{QStringLiteral("abc/Atest1.cpp"), QStringLiteral("abc/Btest1.h"),
+                              QStringLiteral("abc/DefaultFileBuffer.h"),
+                              QStringLiteral("def/xyz/DefaultFileBuffer.cpp"),
+                              QStringLiteral("def/xyz/DefaultFileBuffer.h"), QStringLiteral("Ctest1.cpp")}));
+    }
+
+    void sortedLocaleAware()
+    {
+        const QStringList fileNames{QStringLiteral("zebra.cpp"), QStringLiteral("\u00c4pfel.cpp"),
+                                    QStringLiteral("sub/b.cpp"), QStringLiteral("Birne.cpp"),
+                                    QStringLiteral("\u00e4hnlich.cpp")};
+        cmle::CMakeListsFile file{QByteArray{"add_library(main\n    " + fileNames[0].toLocal8Bit() + "\n)\n"}};
+        QVERIFY(file.isLoaded());
+        file.setSortSectionPolicy(cmle::SortSectionPolicy::Sort);
+        for (const auto& fileName : fileNames.mid(1))
+        {
+            QVERIFY(file.addSourceFile(QStringLiteral("main"), fileName, cppSrcMimeType));
+        }
+
+        // file names with a directory first, then in the order of the locale
+        QStringList expected = fileNames;
+        std::sort(expected.begin(), expected.end(), [](const QString& lhs, const QString& rhs) {
+            const bool lhsHasSlash = lhs.contains(QLatin1Char('/'));
+            if (lhsHasSlash != rhs.contains(QLatin1Char('/')))
+                return lhsHasSlash;
+            return QString::localeAwareCompare(lhs, rhs) < 0;
+        });
+        QCOMPARE(file.sourceFiles(QStringLiteral("main")), expected);
+    }
+
+    void renameEscaped()
+    {
+        cmle::CMakeListsFile file{QByteArray{"add_library(main\n    \"a\\\"b.cpp\"\n    c\\ d.cpp\n    e.cpp\n)\n"}};
+        QVERIFY(file.isLoaded());
+        QCOMPARE(file.sourceFiles(QStringLiteral("main")),
+                 (QStringList{QStringLiteral("a\"b.cpp"), QStringLiteral("c d.cpp"), QStringLiteral("e.cpp")}));
+        QVERIFY(file.renameSourceFile(QStringLiteral("main"), QStringLiteral("e.cpp"), QStringLiteral("f\\g.cpp")));
+        QCOMPARE(file.write(),
+                 QByteArray{"add_library(main\n    \"a\\\"b.cpp\"\n    c\\ d.cpp\n    f\\\\g.cpp\n)\n"});
+    }
+
+    void bracketArguments()
+    {
+        // the comment is longer than the lexer buffer, so its end is found beyond it
+        const QByteArray longComment = QByteArray{"x ]] y\n"}.repeated(4000);
+        const QByteArray head = "#[==[ header\n" + longComment + "]==]\n";
+        cmle::CMakeListsFile file{QByteArray{head + "add_library(lib STATIC\n"
+                                                    "    a.cpp # first\n"
+                                                    "    [=[b c.cpp]=]\n"
+                                                    "    #[[ generated ]] c.cpp\n"
+                                                    ")\n"}};
+        QVERIFY(file.isLoaded());
+        QCOMPARE(file.sourceFiles(QStringLiteral("lib")),
+                 (QStringList{QStringLiteral("a.cpp"), QStringLiteral("b c.cpp"), QStringLiteral("c.cpp")}));
+
+        const auto blocks = file.sourcesBlocks();
+        QCOMPARE(blocks.size(), 1);
+        QCOMPARE(blocks[0].startLine, 4003);
+        QCOMPARE(blocks[0].endLine, 4007);
+
+        QVERIFY(file.renameSourceFile(QStringLiteral("lib"), QStringLiteral("c.cpp"), QStringLiteral("d.cpp")));
+        QVERIFY(file.addSourceFile(QStringLiteral("lib"), QStringLiteral("e.cpp"), cppSrcMimeType));
+        QCOMPARE(file.write(), QByteArray{head + "add_library(lib STATIC\n"
+                                                 "    a.cpp # first\n"
+                                                 "    [=[b c.cpp]=]\n"
+                                                 "    #[[ generated ]] d.cpp\n"
+                                                 "    e.cpp\n"
+                                                 ")\n"});
+    }
+
+    void undoRedo()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        file.setUndoLimit(-1);
+        QVERIFY(!file.canUndo());
+        QVERIFY(file.removeSourceFile(QStringLiteral("main"), QStringLiteral("CMakeListsFile.cpp")));
+        QVERIFY(!file.removeSourceFile(QStringLiteral("main"), QStringLiteral("does_not_exist.cpp")));
+
+        QVERIFY(file.undo());
+        QVERIFY(!file.canUndo());
+        QVERIFY(!file.hasChangedBlocks());
+        fileBuffer = file.write();
+        COMPARE_FILE("two_source_blocks.cmake");
+
+        QVERIFY(file.redo());
+        QVERIFY(!file.canRedo());
+        fileBuffer = file.write();
+        COMPARE_FILE("two_source_blocks-remove_top.cmake");
+    }
+
+    void undoLimit()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        QCOMPARE(file.undoLimit(), 0);
+        QVERIFY(file.removeSourceFile(QStringLiteral("main"), QStringLiteral("CMakeListsFile.cpp")));
+        QVERIFY(!file.canUndo());
+
+        file.setUndoLimit(2);
+        QVERIFY(file.removeSourceFile(QStringLiteral("main"), QStringLiteral("CMakeListsFile.h")));
+        QVERIFY(file.removeSourceFile(QStringLiteral("main"), QStringLiteral("FileBuffer.cpp")));
+        QVERIFY(file.removeSourceFile(QStringLiteral("main"), QStringLiteral("FileBuffer.h")));
+        QVERIFY(file.undo());
+        QVERIFY(file.undo());
+        QVERIFY(!file.canUndo());
+        QVERIFY(file.sourceFiles(QStringLiteral("main")).contains(QStringLiteral("FileBuffer.cpp")));
+        QVERIFY(!file.sourceFiles(QStringLiteral("main")).contains(QStringLiteral("CMakeListsFile.h")));
+
+        file.setUndoLimit(1);
+        QVERIFY(file.redo());
+        QVERIFY(!file.canRedo());
+        QVERIFY(file.canUndo());
+    }
+
+    void restoreForeignSnapshot()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        cmle::CMakeListsFile::Snapshot foreignSnapshot;
+        {
+            cmle::CMakeListsFile other{fileBuffer};
+            QVERIFY(other.removeSourceFile(QStringLiteral("main"), QStringLiteral("CMakeListsFile.cpp")));
+            foreignSnapshot = other.snapshot();
+        }
+
+        // even with another file allocated in place of the destroyed one
+        cmle::CMakeListsFile reused{fileBuffer};
+        QTest::ignoreMessage(QtWarningMsg, "Snapshot does not belong to this CMakeLists file");
+        reused.restore(foreignSnapshot);
+        QVERIFY(!reused.hasChangedBlocks());
+        QTest::ignoreMessage(QtWarningMsg, "Snapshot does not belong to this CMakeLists file");
+        file.restore(foreignSnapshot);
+        QVERIFY(!file.hasChangedBlocks());
+    }
+
+    void snapshotRestore()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        file.setUndoLimit(-1);
+        const auto snapshot = file.snapshot();
+        QVERIFY(file.removeSourceFile(QStringLiteral("main"), QStringLiteral("CMakeListsFile.cpp")));
+        const auto removedSnapshot = file.snapshot();
+        QVERIFY(file.renameSourceFile(QStringLiteral("main"), QStringLiteral("abc/DefaultFileBuffer.cpp"),
+                                      QStringLiteral("Atest1.cpp")));
+
+        file.restore(removedSnapshot);
+        fileBuffer = file.write();
+        COMPARE_FILE("two_source_blocks-remove_top.cmake");
+
+        file.restore(snapshot);
+        fileBuffer = file.write();
+        COMPARE_FILE("two_source_blocks.cmake");
+
+        // restoring does not change the snapshot
+        QVERIFY(file.undo());
+        file.restore(snapshot);
+        QVERIFY(!file.hasChangedBlocks());
+    }
+
+    void bulkRemove()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        file.setUndoLimit(-1);
+        file.setSortSectionPolicy(cmle::SortSectionPolicy::Sort);
+        QCOMPARE(file.removeSourceFiles(QStringLiteral("main"),
+                                        QRegularExpression::fromWildcard(QStringLiteral("*DefaultFileBuffer.*"))), 4);
+        QCOMPARE(file.sourceFiles(QStringLiteral("main")),
+                 (QStringList{QStringLiteral("CMakeListsFile.cpp"), QStringLiteral("CMakeListsFile.h"),
+                              QStringLiteral("FileBuffer.cpp"), QStringLiteral("FileBuffer.h")}));
+
+        QVERIFY(file.undo());
+        QCOMPARE(file.sourceFiles(QStringLiteral("main")).size(), 8);
+    }
+
+    void bulkRenamePrefix()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        file.setSortSectionPolicy(cmle::SortSectionPolicy::Sort);
+        QCOMPARE(file.renameSourceFilePrefix({}, QStringLiteral("abc/"), QStringLiteral("xyz/")), 2);
+        QCOMPARE(file.sourceFiles(QStringLiteral("main")).mid(2),
+                 (QStringList{QStringLiteral("def/xyz/DefaultFileBuffer.cpp"),
+                              QStringLiteral("def/xyz/DefaultFileBuffer.h"),
+                              QStringLiteral("xyz/DefaultFileBuffer.cpp"), QStringLiteral("xyz/DefaultFileBuffer.h"),
+                              QStringLiteral("FileBuffer.cpp"), QStringLiteral("FileBuffer.h")}));
+    }
+
+    void bulkReplace()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        file.setUndoLimit(-1);
+        QCOMPARE(file.replaceSourceFiles(QStringLiteral("main"), QRegularExpression{QStringLiteral("\\.h$")},
+                                         QStringLiteral(".hpp")), 4);
+        QCOMPARE(file.targetsOfSourceFile(QStringLiteral("abc/DefaultFileBuffer.hpp")),
+                 QStringList{QStringLiteral("main")});
+        QVERIFY(file.targetsOfSourceFile(QStringLiteral("abc/DefaultFileBuffer.h")).isEmpty());
+
+        // nothing matches, nothing to undo
+        QVERIFY(file.undo());
+        QCOMPARE(file.replaceSourceFiles({}, QRegularExpression{QStringLiteral("\\.cxx$")}, {}), 0);
+        QVERIFY(!file.canUndo());
+    }
+
+    void concurrentReads()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        const auto fileCount = file.sourceFiles(QStringLiteral("main")).size();
+
+        std::atomic_bool stop{false};
+        std::atomic_int errors{0};
+
+        QList<QThread*> readers;
+        for (int i = 0; i < 4; ++i)
+        {
+            readers << QThread::create([&]() {
+                while (!stop)
+                {
+                    const auto snapshot = file.snapshot();
+                    const auto fileNames = snapshot.sourceFiles(QStringLiteral("main"));
+                    const bool added = fileNames.contains(QStringLiteral("Atest1.cpp"));
+                    if (fileNames.size() != fileCount + (added ? 1 : 0) ||
+                            snapshot.targetsOfSourceFile(QStringLiteral("Atest1.cpp")).isEmpty() == added)
+                        ++errors;
+                }
+            });
+            readers.last()->start();
+        }
+
+        for (int i = 0; i < 200; ++i)
+        {
+            QVERIFY(file.addSourceFile(QStringLiteral("main"), QStringLiteral("Atest1.cpp"), cppSrcMimeType));
+            QVERIFY(file.removeSourceFile(QStringLiteral("main"), QStringLiteral("Atest1.cpp")));
+        }
+
+        stop = true;
+        for (auto* reader : qAsConst(readers))
+        {
+            reader->wait();
+            delete reader;
+        }
+
+        QCOMPARE(errors.load(), 0);
+        QCOMPARE(file.sourceFiles(QStringLiteral("main")).size(), fileCount);
+    }
+
     void addToEmptySourceBlock()
     {
         CMAKE_FILE("empty_source_block.cmake");
@@ -187,6 +483,50 @@ private slots:
         COMPARE_FILE("empty_source_block-add.cmake");
     }
 
+    void queryTargets()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        QCOMPARE(file.targets(), QStringList{QStringLiteral("main")});
+    }
+
+    void querySourceFiles()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        QCOMPARE(file.sourceFiles(QStringLiteral("main")).size(), 8);
+        QCOMPARE(file.sourceFiles(QStringLiteral("main"), QStringLiteral("private")).size(), 8);
+        QVERIFY(file.sourceFiles(QStringLiteral("main"), QStringLiteral("PUBLIC")).isEmpty());
+        QVERIFY(file.sourceFiles(QStringLiteral("unknown")).isEmpty());
+    }
+
+    void queryTargetsOfSourceFile()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        QCOMPARE(file.targetsOfSourceFile(QStringLiteral("abc/DefaultFileBuffer.cpp")),
+                 QStringList{QStringLiteral("main")});
+        QVERIFY(file.targetsOfSourceFile(QStringLiteral("Atest1.cpp")).isEmpty());
+
+        file.addSourceFile(QStringLiteral("main"), QStringLiteral("Atest1.cpp"), cppSrcMimeType);
+        QCOMPARE(file.targetsOfSourceFile(QStringLiteral("Atest1.cpp")), QStringList{QStringLiteral("main")});
+
+        file.removeSourceFile(QStringLiteral("main"), QStringLiteral("Atest1.cpp"));
+        QVERIFY(file.targetsOfSourceFile(QStringLiteral("Atest1.cpp")).isEmpty());
+    }
+
+    void querySourcesBlocks()
+    {
+        CMAKE_FILE("two_source_blocks.cmake");
+        const auto blocks = file.sourcesBlocks();
+        QCOMPARE(blocks.size(), 3);
+        QCOMPARE(blocks[1].functionName, QStringLiteral("target_sources"));
+        QCOMPARE(blocks[1].target, QStringLiteral("main"));
+        QCOMPARE(blocks[1].startLine, 3);
+        QCOMPARE(blocks[1].endLine, 6);
+        QCOMPARE(blocks[1].sections.size(), 1);
+        QCOMPARE(blocks[1].sections[0].name, QStringLiteral("PRIVATE"));
+        QCOMPARE(blocks[1].sections[0].fileNames,
+                 (QStringList{QStringLiteral("CMakeListsFile.cpp"), QStringLiteral("CMakeListsFile.h")}));
+    }
+
     void addInInvalid()
     {
         QSKIP("Source block validation not implemented yet in CMakeListsFile");
@@ -0,0 +1,189 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "TestResources.h"
+#include <cmle/CMakeListsFile.h>
+#include <cmle/CMakeListsProject.h>
+#include <QtTest>
+
+namespace {
+
+using cmle::test::resourceFile;
+
+bool setModified(const QString& fileName, const QDateTime& modified)
+{
+    QFile f{fileName};
+    return f.open(QFile::ReadWrite) && f.setFileTime(modified, QFile::FileModificationTime);
+}
+
+// copies the project with modification times far enough in the past to be cached
+bool copyProject(const QString& targetDir, const QDateTime& modified)
+{
+    const QDir sourceDir{resourceFile("project")};
+    QDirIterator it{sourceDir.path(), QDir::Files, QDirIterator::Subdirectories};
+    while (it.hasNext())
+    {
+        const QString sourceFile = it.next();
+        const QString targetFile = targetDir + QLatin1Char('/') + sourceDir.relativeFilePath(sourceFile);
+        if (!QDir{}.mkpath(QFileInfo{targetFile}.path()) || !QFile::copy(sourceFile, targetFile) ||
+                !QFile::setPermissions(targetFile, QFile::ReadOwner | QFile::WriteOwner) ||
+                !setModified(targetFile, modified))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+class CMakeListsProjectTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void loadAddSubdirectory()
+    {
+        cmle::CMakeListsProject project;
+        QVERIFY(project.load(resourceFile("project/CMakeLists.txt")));
+
+        QCOMPARE(project.fileNames(), (QStringList{
+                                           resourceFile("project/CMakeLists.txt"),
+                                           resourceFile("project/lib/CMakeLists.txt"),
+                                           resourceFile("project/app/CMakeLists.txt"),
+                                           resourceFile("project/lib/sub/CMakeLists.txt"),
+                                       }));
+        QCOMPARE(project.targets(), (QStringList{QStringLiteral("app"), QStringLiteral("lib")}));
+    }
+
+    void loadGlob()
+    {
+        cmle::CMakeListsProject project;
+        project.setSubdirectoryDiscovery(cmle::SubdirectoryDiscovery::AddSubdirectoryAndGlob);
+        QVERIFY(project.load(resourceFile("project/CMakeLists.txt")));
+
+        QCOMPARE(project.fileNames().size(), 5);
+        QVERIFY(project.fileNames().contains(resourceFile("project/extra/CMakeLists.txt")));
+        QCOMPARE(project.targets(), (QStringList{QStringLiteral("app"), QStringLiteral("extra"),
+                                                 QStringLiteral("lib")}));
+    }
+
+    void targetLocations()
+    {
+        cmle::CMakeListsProject project;
+        QVERIFY(project.load(resourceFile("project/CMakeLists.txt")));
+
+        const auto locations = project.targetLocations(QStringLiteral("lib"));
+        QCOMPARE(locations.size(), 3);
+
+        QCOMPARE(locations[0].fileName, resourceFile("project/CMakeLists.txt"));
+        QCOMPARE(locations[0].functionName, QStringLiteral("target_sources"));
+        QCOMPARE(locations[0].startLine, 9);
+
+        QCOMPARE(locations[1].fileName, resourceFile("project/lib/CMakeLists.txt"));
+        QCOMPARE(locations[1].functionName, QStringLiteral("add_library"));
+
+        QCOMPARE(locations[2].fileName, resourceFile("project/lib/sub/CMakeLists.txt"));
+        QCOMPARE(locations[2].functionName, QStringLiteral("target_sources"));
+
+        auto file = project.file(locations[2].fileName);
+        QVERIFY(file);
+        QCOMPARE(file->sourceFiles(QStringLiteral("lib")),
+                 (QStringList{QStringLiteral("Sub.cpp"), QStringLiteral("Sub.h")}));
+    }
+
+    void loadCached()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        const QDateTime oldModified = QDateTime::currentDateTime().addDays(-1);
+        QVERIFY(copyProject(tempDir.path(), oldModified));
+
+        const QString rootFile = tempDir.filePath(QStringLiteral("CMakeLists.txt"));
+        const QString subFile = tempDir.filePath(QStringLiteral("lib/sub/CMakeLists.txt"));
+        const QString cacheFile = tempDir.filePath(QStringLiteral("cmle.cache"));
+
+        {
+            cmle::CMakeListsProject project;
+            project.setCacheFileName(cacheFile);
+            QVERIFY(project.load(rootFile));
+            QVERIFY(QFileInfo::exists(cacheFile));
+        }
+
+        // same size and time stamp, so the cache wins over the file content
+        {
+            QFile f{subFile};
+            QVERIFY(f.open(QFile::WriteOnly));
+            f.write("target_sources(lix PRIVATE\n    Sub.cpp\n    Sub.h\n)\n");
+        }
+        QVERIFY(setModified(subFile, oldModified));
+
+        {
+            cmle::CMakeListsProject project;
+            project.setCacheFileName(cacheFile);
+            QVERIFY(project.load(rootFile));
+
+            QCOMPARE(project.fileNames().size(), 4);
+            QCOMPARE(project.targets(), (QStringList{QStringLiteral("app"), QStringLiteral("lib")}));
+            QCOMPARE(project.targetLocations(QStringLiteral("lib")).size(), 3);
+
+            // files are parsed on first access
+            auto file = project.file(subFile);
+            QVERIFY(file);
+            QCOMPARE(file->targets(), QStringList{QStringLiteral("lix")});
+        }
+
+        QVERIFY(setModified(subFile, oldModified.addSecs(1)));
+
+        {
+            cmle::CMakeListsProject project;
+            project.setCacheFileName(cacheFile);
+            QVERIFY(project.load(rootFile));
+
+            QCOMPARE(project.targets(), (QStringList{QStringLiteral("app"), QStringLiteral("lib"),
+                                                     QStringLiteral("lix")}));
+        }
+    }
+
+    void watch()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        QVERIFY(copyProject(tempDir.path(), QDateTime::currentDateTime().addDays(-1)));
+
+        cmle::CMakeListsProject project;
+        QVERIFY(project.load(tempDir.filePath(QStringLiteral("CMakeLists.txt"))));
+        project.setWatching(true);
+
+        QSignalSpy fileSpy{&project, &cmle::CMakeListsProject::fileChanged};
+        QSignalSpy targetsSpy{&project, &cmle::CMakeListsProject::targetsChanged};
+
+        const QString subFile = tempDir.filePath(QStringLiteral("lib/sub/CMakeLists.txt"));
+        {
+            QSaveFile f{subFile};
+            QVERIFY(f.open(QFile::WriteOnly));
+            f.write("target_sources(lix PRIVATE\n    Sub.cpp\n    Sub.h\n)\n");
+            QVERIFY(f.commit());
+        }
+
+        QVERIFY(targetsSpy.wait());
+        QCOMPARE(fileSpy.size(), 1);
+        QCOMPARE(fileSpy[0][0].toString(), subFile);
+        QCOMPARE(targetsSpy[0][0].toStringList(), (QStringList{QStringLiteral("lib"), QStringLiteral("lix")}));
+
+        QCOMPARE(project.targets(), (QStringList{QStringLiteral("app"), QStringLiteral("lib"), QStringLiteral("lix")}));
+        QCOMPARE(project.targetLocations(QStringLiteral("lib")).size(), 2);
+        QCOMPARE(project.targetLocations(QStringLiteral("lix")).size(), 1);
+        QCOMPARE(project.file(subFile)->targets(), QStringList{QStringLiteral("lix")});
+    }
+
+    void loadMissing()
+    {
+        cmle::CMakeListsProject project;
+        QTest::ignoreMessage(QtCriticalMsg, QRegularExpression(QStringLiteral("^Could not open")));
+        QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("^Could not load")));
+        QVERIFY(!project.load(resourceFile("project/does_not_exist/CMakeLists.txt")));
+        QVERIFY(project.fileNames().isEmpty());
+    }
+};
+
+#include "test_CMakeListsProject.moc"
+QTEST_MAIN(CMakeListsProjectTest)
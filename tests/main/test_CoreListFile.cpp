@@ -0,0 +1,232 @@
+// Copyright 2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "TestResources.h"
+#include <cmle/core/ListFile.h>
+#include <QtTest>
+#include <algorithm>
+
+namespace {
+
+std::string fileData(const char* name)
+{
+    return cmle::test::fileData(cmle::test::resourceFile(name)).toStdString();
+}
+
+using Strings = std::vector<std::string>;
+
+} // namespace
+
+Q_DECLARE_METATYPE(cmle::core::SortSectionPolicy)
+
+// CMakeListsFile is built on this layer, the expected files are shared with its tests.
+class CoreListFileTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void edit_data()
+    {
+        QTest::addColumn<QString>("command");
+        QTest::addColumn<QStringList>("arguments");
+        QTest::addColumn<cmle::core::SortSectionPolicy>("policy");
+        QTest::addColumn<QString>("input");
+        QTest::addColumn<QString>("expected");
+
+        const auto noSort = cmle::core::SortSectionPolicy::NoSort;
+        const auto sort = cmle::core::SortSectionPolicy::Sort;
+        const auto twoBlocks = QStringLiteral("two_source_blocks.cmake");
+
+        QTest::newRow("addNoPrefix") << QStringLiteral("add") << QStringList{QStringLiteral("Atest1.cpp")}
+                                     << noSort << twoBlocks << QStringLiteral("two_source_blocks-no_prefix.cmake");
+        QTest::newRow("addSamePrefix") << QStringLiteral("add") << QStringList{QStringLiteral("abc/Atest1.cpp")}
+                                       << noSort << twoBlocks << QStringLiteral("two_source_blocks-same_prefix.cmake");
+        QTest::newRow("addDifferentPrefix") << QStringLiteral("add") << QStringList{QStringLiteral("xyz/Atest1.cpp")}
+                                            << noSort << twoBlocks
+                                            << QStringLiteral("two_source_blocks-different_prefix.cmake");
+        QTest::newRow("addPartialPrefix") << QStringLiteral("add") << QStringList{QStringLiteral("abc/xyz/Atest1.cpp")}
+                                          << noSort << twoBlocks
+                                          << QStringLiteral("two_source_blocks-partial_prefix_1.cmake");
+        QTest::newRow("addSorted") << QStringLiteral("add") << QStringList{QStringLiteral("Atest1.cpp")}
+                                   << sort << twoBlocks << QStringLiteral("two_source_blocks-no_prefix_sorted.cmake");
+        QTest::newRow("addToDefault") << QStringLiteral("add") << QStringList{QStringLiteral("Atest1.cpp")}
+                                      << noSort << QStringLiteral("no_source_block.cmake")
+                                      << QStringLiteral("no_source_block-default.cmake");
+        QTest::newRow("addToEmpty") << QStringLiteral("add") << QStringList{QStringLiteral("Atest1.cpp")}
+                                    << noSort << QStringLiteral("empty_source_block.cmake")
+                                    << QStringLiteral("empty_source_block-add.cmake");
+        QTest::newRow("removeTop") << QStringLiteral("del") << QStringList{QStringLiteral("CMakeListsFile.cpp")}
+                                   << noSort << twoBlocks << QStringLiteral("two_source_blocks-remove_top.cmake");
+        QTest::newRow("removeSorted") << QStringLiteral("del")
+                                      << QStringList{QStringLiteral("abc/DefaultFileBuffer.cpp")} << sort << twoBlocks
+                                      << QStringLiteral("two_source_blocks-remove_bottom_sorted.cmake");
+        QTest::newRow("renameTop") << QStringLiteral("ren")
+                                   << QStringList{QStringLiteral("CMakeListsFile.cpp"), QStringLiteral("Atest1.cpp")}
+                                   << noSort << twoBlocks << QStringLiteral("two_source_blocks-rename_top.cmake");
+        QTest::newRow("renameSorted") << QStringLiteral("ren")
+                                      << QStringList{QStringLiteral("abc/DefaultFileBuffer.cpp"),
+                                                     QStringLiteral("Atest1.cpp")}
+                                      << sort << twoBlocks
+                                      << QStringLiteral("two_source_blocks-rename_bottom_sorted.cmake");
+    }
+
+    void edit()
+    {
+        QFETCH(QString, command);
+        QFETCH(QStringList, arguments);
+        QFETCH(cmle::core::SortSectionPolicy, policy);
+        QFETCH(QString, input);
+        QFETCH(QString, expected);
+
+        cmle::core::ListFile file{fileData(qPrintable(input))};
+        QVERIFY(file.isLoaded());
+        file.setSortSectionPolicy(policy);
+
+        bool result{};
+        if (command == QLatin1String("add"))
+            result = file.addSourceFile("main", arguments[0].toStdString());
+        else if (command == QLatin1String("del"))
+            result = file.removeSourceFile("main", arguments[0].toStdString());
+        else
+            result = file.renameSourceFile("main", arguments[0].toStdString(), arguments[1].toStdString());
+
+        QVERIFY(result);
+        QVERIFY(file.hasChangedBlocks());
+        QCOMPARE(file.write(), fileData(qPrintable(expected)));
+    }
+
+    void unchanged()
+    {
+        const auto content = fileData("two_source_blocks.cmake");
+        cmle::core::ListFile file{content};
+        QVERIFY(!file.removeSourceFile("main", "does_not_exist.cpp"));
+        QVERIFY(!file.addSourceFile("unknown", "Atest1.cpp"));
+        QVERIFY(!file.hasChangedBlocks());
+        QCOMPARE(file.write(), content);
+    }
+
+    void parseError()
+    {
+        cmle::core::ListFile file{fileData("invalid_listsfile.cmake")};
+        QVERIFY(!file.isLoaded());
+    }
+
+    void keepsComments()
+    {
+        cmle::core::ListFile file{"add_library(lib STATIC\n"
+                                  "    a.cpp # first\n"
+                                  "    [=[b.cpp]=]\n"
+                                  "    #[[ generated ]] c.cpp\n"
+                                  ")\n"};
+        QVERIFY(file.isLoaded());
+        QCOMPARE(file.sourceFiles("lib"), (Strings{"a.cpp", "b.cpp", "c.cpp"}));
+
+        QVERIFY(file.renameSourceFile("lib", "c.cpp", "d.cpp"));
+        QVERIFY(file.addSourceFile("lib", "e f.cpp"));
+        QCOMPARE(file.write(), std::string{"add_library(lib STATIC\n"
+                                           "    a.cpp # first\n"
+                                           "    [=[b.cpp]=]\n"
+                                           "    #[[ generated ]] d.cpp\n"
+                                           "    \"e f.cpp\"\n"
+                                           ")\n"});
+    }
+
+    void unescapedValues()
+    {
+        cmle::core::ListFile file{"add_library(lib \"a\\tb.cpp\" c\\;d.cpp e\\\\f.cpp \"g\\\"h.cpp\" plain.cpp)\n"};
+        QCOMPARE(file.sourceFiles("lib"), (Strings{"a\tb.cpp", "c;d.cpp", "e\\f.cpp", "g\"h.cpp", "plain.cpp"}));
+    }
+
+    void copies()
+    {
+        cmle::core::ListFile file{fileData("two_source_blocks.cmake")};
+        const cmle::core::ListFile copy{file};
+        QVERIFY(file.removeSourceFile("main", "CMakeListsFile.cpp"));
+
+        QVERIFY(!copy.hasChangedBlocks());
+        QCOMPARE(copy.write(), fileData("two_source_blocks.cmake"));
+        QCOMPARE(file.write(), fileData("two_source_blocks-remove_top.cmake"));
+
+        file = copy;
+        QVERIFY(!file.hasChangedBlocks());
+        QCOMPARE(file.sourceFiles("main").size(), size_t{8});
+    }
+
+    void copiesOfLargeSection()
+    {
+        // enough files for several chunks, the edits split and empty some of them
+        Strings fileNames;
+        std::string content = "add_library(main STATIC\n";
+        for (int i = 0; i < 300; ++i)
+        {
+            fileNames.push_back("src/file" + std::to_string(1000 + i) + ".cpp");
+            content += "    " + fileNames.back() + "\n";
+        }
+        content += ")\n";
+
+        cmle::core::ListFile file{content};
+        file.setSortSectionPolicy(cmle::core::SortSectionPolicy::Sort);
+        const cmle::core::ListFile copy{file};
+
+        Strings expected = fileNames;
+        for (int i = 0; i < 150; ++i)
+        {
+            const std::string added = "src/file" + std::to_string(1000 + i) + "a.cpp";
+            QVERIFY(file.addSourceFile("main", added));
+            expected.insert(std::upper_bound(expected.begin(), expected.end(), added), added);
+        }
+        for (int i = 0; i < 64; ++i)
+        {
+            const std::string removed = "src/file" + std::to_string(1100 + i) + ".cpp";
+            QVERIFY(file.removeSourceFile("main", removed));
+            expected.erase(std::find(expected.begin(), expected.end(), removed));
+        }
+        QVERIFY(file.renameSourceFile("main", "src/file1299.cpp", "src/file0.cpp"));
+        expected.pop_back();
+        expected.insert(expected.begin(), "src/file0.cpp");
+
+        QCOMPARE(file.sourceFiles("main"), expected);
+        QCOMPARE(cmle::core::ListFile{file.write()}.sourceFiles("main"), expected);
+        QCOMPARE(copy.sourceFiles("main"), fileNames);
+        QCOMPARE(copy.write(), content);
+    }
+
+    void fileNameCompare()
+    {
+        cmle::core::ListFile file{"add_library(main\n    b.cpp\n    c.cpp\n    a.cpp\n)\n"};
+        file.setSortSectionPolicy(cmle::core::SortSectionPolicy::Sort);
+        QVERIFY(file.removeSourceFile("main", "c.cpp"));
+        QCOMPARE(file.sourceFiles("main"), (Strings{"a.cpp", "b.cpp"}));
+
+        // sorted again in the new order, which copies keep
+        file.setFileNameCompare([](std::string_view lhs, std::string_view rhs) { return rhs.compare(lhs); });
+        const cmle::core::ListFile copy{file};
+        QVERIFY(file.addSourceFile("main", "c.cpp"));
+        QCOMPARE(file.sourceFiles("main"), (Strings{"c.cpp", "b.cpp", "a.cpp"}));
+        cmle::core::ListFile edited{copy};
+        QVERIFY(edited.addSourceFile("main", "ab.cpp"));
+        QCOMPARE(edited.sourceFiles("main"), (Strings{"b.cpp", "ab.cpp", "a.cpp"}));
+    }
+
+    void addToNamedSection()
+    {
+        cmle::core::ListFile file{"target_sources(main\n    PUBLIC\n        a.h\n    PRIVATE\n        a.cpp\n)\n"};
+        QVERIFY(file.addSourceFile("main", "b.h", "public"));
+        QVERIFY(file.addSourceFile("main", "b.cpp", "PRIVATE"));
+        QCOMPARE(file.sourceFiles("main", "PUBLIC"), (Strings{"a.h", "b.h"}));
+        QCOMPARE(file.sourceFiles("main", "PRIVATE"), (Strings{"a.cpp", "b.cpp"}));
+    }
+
+    void queries()
+    {
+        cmle::core::ListFile file{fileData("two_source_blocks.cmake")};
+        QCOMPARE(file.targets(), Strings{"main"});
+        QCOMPARE(file.sourceFiles("main").size(), size_t{8});
+        QCOMPARE(file.sourceFiles("main", "private").size(), size_t{8});
+        QVERIFY(file.sourceFiles("main", "PUBLIC").empty());
+        QVERIFY(file.sourceFiles("unknown").empty());
+    }
+};
+
+#include "test_CoreListFile.moc"
+QTEST_MAIN(CoreListFileTest)
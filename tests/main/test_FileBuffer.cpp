@@ -0,0 +1,177 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "TestResources.h"
+#include <cmle/AsyncFileLoader.h>
+#include <cmle/MappedFileBuffer.h>
+#include <cmle/RawDataFileBuffer.h>
+#include <cmle/StandardFileBuffer.h>
+#include <QtTest>
+
+namespace {
+
+using cmle::test::fileData;
+using cmle::test::resourceFile;
+
+} // namespace
+
+#define TEMP_COPY(fileName) \
+    QTemporaryDir tempDir; \
+    QVERIFY(tempDir.isValid()); \
+    const QString tempFile = tempDir.filePath(QStringLiteral("CMakeLists.txt")); \
+    QVERIFY(QFile::copy(resourceFile(fileName), tempFile)); \
+    QVERIFY(QFile::setPermissions(tempFile, QFile::ReadOwner | QFile::WriteOwner)); \
+    const QDateTime oldModified = QDateTime::currentDateTime().addDays(-1); \
+    { \
+        QFile f{tempFile}; \
+        QVERIFY(f.open(QFile::ReadWrite)); \
+        QVERIFY(f.setFileTime(oldModified, QFile::FileModificationTime)); \
+    }
+
+class FileBufferTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void loadGood()
+    {
+        cmle::StandardFileBuffer buffer{resourceFile("two_source_blocks.cmake")};
+        QVERIFY(buffer.load());
+        QVERIFY(!buffer.isDirty());
+        QCOMPARE(buffer.content(), fileData(resourceFile("two_source_blocks.cmake")));
+    }
+
+    void loadUnknownSize()
+    {
+#ifdef Q_OS_LINUX
+        // files in /proc report a size of 0
+        cmle::StandardFileBuffer buffer{QStringLiteral("/proc/self/status")};
+        QVERIFY(buffer.load());
+        QVERIFY(buffer.content().startsWith("Name:"));
+#else
+        QSKIP("Test requires the /proc file system");
+#endif
+    }
+
+    void loadMissing()
+    {
+        cmle::StandardFileBuffer buffer{resourceFile("does_not_exist.cmake")};
+        QTest::ignoreMessage(QtCriticalMsg, QRegularExpression(QStringLiteral("^Could not open")));
+        QVERIFY(!buffer.load());
+    }
+
+    void saveChanged()
+    {
+        TEMP_COPY("two_source_blocks.cmake");
+        cmle::StandardFileBuffer buffer{tempFile};
+        buffer.setSavePolicy(cmle::SavePolicy::SkipUnchanged);
+        QVERIFY(buffer.load());
+        buffer.setContent(fileData(resourceFile("two_source_blocks-remove_top.cmake")));
+        QVERIFY(buffer.isDirty());
+        QVERIFY(buffer.save());
+        QVERIFY(!buffer.isDirty());
+        QCOMPARE(fileData(tempFile), fileData(resourceFile("two_source_blocks-remove_top.cmake")));
+        QVERIFY(QFileInfo{tempFile}.lastModified() != oldModified);
+        QCOMPARE(QDir{tempDir.path()}.entryList(QDir::Files).size(), 1);
+    }
+
+    void saveUnchangedOverwrite()
+    {
+        TEMP_COPY("two_source_blocks.cmake");
+        cmle::StandardFileBuffer buffer{tempFile};
+        QVERIFY(buffer.load());
+        buffer.setContent(buffer.content());
+        QVERIFY(buffer.save());
+        QVERIFY(QFileInfo{tempFile}.lastModified() != oldModified);
+    }
+
+    void saveUnchangedSkip()
+    {
+        TEMP_COPY("two_source_blocks.cmake");
+        cmle::StandardFileBuffer buffer{tempFile};
+        buffer.setSavePolicy(cmle::SavePolicy::SkipUnchanged);
+        QVERIFY(buffer.load());
+        buffer.setContent(buffer.content());
+        QVERIFY(buffer.save());
+        QVERIFY(!buffer.isDirty());
+        QCOMPARE(QFileInfo{tempFile}.lastModified(), oldModified);
+    }
+
+    void saveUnchangedSkipNotLoaded()
+    {
+        TEMP_COPY("two_source_blocks.cmake");
+        cmle::StandardFileBuffer buffer{tempFile};
+        buffer.setSavePolicy(cmle::SavePolicy::SkipUnchanged);
+        buffer.setContent(fileData(resourceFile("two_source_blocks.cmake")));
+        QVERIFY(buffer.save());
+        QCOMPARE(QFileInfo{tempFile}.lastModified(), oldModified);
+    }
+
+    void loadMapped()
+    {
+        cmle::MappedFileBuffer buffer{resourceFile("two_source_blocks.cmake")};
+        QVERIFY(buffer.load());
+        QVERIFY(!buffer.isDirty());
+        QCOMPARE(buffer.content(), fileData(resourceFile("two_source_blocks.cmake")));
+
+        buffer.setContent(QByteArrayLiteral("project(test)\n"));
+        QVERIFY(buffer.isDirty());
+        QCOMPARE(buffer.content(), QByteArrayLiteral("project(test)\n"));
+    }
+
+    void loadMappedEmpty()
+    {
+        cmle::MappedFileBuffer buffer{resourceFile("empty_file.cmake")};
+        QVERIFY(buffer.load());
+        QVERIFY(buffer.content().isEmpty());
+    }
+
+    void rawDataNoCopy()
+    {
+        const QByteArray data = fileData(resourceFile("two_source_blocks.cmake"));
+        cmle::RawDataFileBuffer buffer{data};
+        QCOMPARE(buffer.content(), data);
+        QCOMPARE(buffer.content().constData(), data.constData());
+    }
+
+    void asyncLoad()
+    {
+        QStringList fileNames;
+        const auto entries = QDir{QLatin1String(RESOURCE_DIR)}.entryInfoList(QDir::Files);
+        for (const auto& entry : entries)
+        {
+            fileNames << entry.filePath();
+        }
+        QVERIFY(!fileNames.isEmpty());
+        fileNames << resourceFile("does_not_exist.cmake");
+
+        QMutex mutex;
+        QMap<QString, std::tuple<QByteArray, bool>> results;
+
+        QTest::ignoreMessage(QtCriticalMsg, QRegularExpression(QStringLiteral("^Could not open")));
+        cmle::AsyncFileLoader loader;
+        loader.setMaxConcurrentReads(4);
+        loader.load(fileNames, [&](const QString& fileName, const QByteArray& content, bool success) {
+            QMutexLocker lock{&mutex};
+            results.insert(fileName, {content, success});
+        });
+
+        QCOMPARE(results.size(), fileNames.size());
+        for (const auto& fileName : qAsConst(fileNames))
+        {
+            const auto [content, success] = results.value(fileName);
+            if (fileName == resourceFile("does_not_exist.cmake"))
+            {
+                QVERIFY(!success);
+            }
+            else
+            {
+                QVERIFY(success);
+                QCOMPARE(content, fileData(fileName));
+            }
+        }
+    }
+};
+
+#include "test_FileBuffer.moc"
+QTEST_MAIN(FileBufferTest)
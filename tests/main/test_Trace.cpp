@@ -0,0 +1,76 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "TestResources.h"
+#include <cmle/CMakeListsFile.h>
+#include <cmle/Trace.h>
+#include <QtTest>
+
+namespace {
+
+using cmle::test::fileData;
+using cmle::test::resourceFile;
+
+QJsonArray traceEvents()
+{
+    return QJsonDocument::fromJson(cmle::trace::toChromeTrace()).object().value(QLatin1String("traceEvents")).toArray();
+}
+
+void editFile()
+{
+    cmle::CMakeListsFile file{fileData(resourceFile("two_source_blocks.cmake"))};
+    QVERIFY(file.isLoaded());
+    file.setSortSectionPolicy(cmle::SortSectionPolicy::Sort);
+    QVERIFY(file.addSourceFile(QStringLiteral("main"), QStringLiteral("Atest1.cpp")));
+    QVERIFY(!file.write().isEmpty());
+}
+
+} // namespace
+
+class TraceTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup()
+    {
+        cmle::trace::setEnabled(false);
+        cmle::trace::clear();
+    }
+
+    void phases()
+    {
+        cmle::trace::setEnabled(true);
+        editFile();
+
+        QMap<QString, QJsonObject> events;
+        const auto array = traceEvents();
+        for (const auto& value : array)
+        {
+            const auto event = value.toObject();
+            events.insert(event.value(QLatin1String("name")).toString(), event);
+        }
+
+        for (const char* phase : {"readCMakeFile", "readInFunctions", "findBestInsertSection", "sortFileNames", "write"})
+        {
+            const auto event = events.value(QLatin1String(phase));
+            QCOMPARE(event.value(QLatin1String("ph")).toString(), QStringLiteral("X"));
+            QVERIFY(event.value(QLatin1String("dur")).toDouble() >= 0.0);
+        }
+
+        const auto tokens = events.value(QStringLiteral("tokensLexed"));
+        QCOMPARE(tokens.value(QLatin1String("ph")).toString(), QStringLiteral("C"));
+        QVERIFY(tokens.value(QLatin1String("args")).toObject().value(QLatin1String("value")).toInteger() > 0);
+        QCOMPARE(events.value(QStringLiteral("sourcesFunctions")).value(QLatin1String("args")).toObject()
+                 .value(QLatin1String("value")).toInteger(), qint64{3});
+    }
+
+    void disabled()
+    {
+        editFile();
+        QVERIFY(traceEvents().isEmpty());
+    }
+};
+
+#include "test_Trace.moc"
+QTEST_MAIN(TraceTest)
@@ -0,0 +1,78 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "TestResources.h"
+#include <cmle/CMakeListsFile.h>
+#include <cmle/Transaction.h>
+#include <QtTest>
+
+namespace {
+
+using cmle::test::fileData;
+using cmle::test::resourceFile;
+
+} // namespace
+
+#define TEMP_PROJECT() \
+    QTemporaryDir tempDir; \
+    QVERIFY(tempDir.isValid()); \
+    const QString appFile = tempDir.filePath(QStringLiteral("app/CMakeLists.txt")); \
+    const QString subFile = tempDir.filePath(QStringLiteral("lib/sub/CMakeLists.txt")); \
+    QVERIFY(QDir{}.mkpath(tempDir.filePath(QStringLiteral("app")))); \
+    QVERIFY(QDir{}.mkpath(tempDir.filePath(QStringLiteral("lib/sub")))); \
+    QVERIFY(QFile::copy(resourceFile("project/app/CMakeLists.txt"), appFile)); \
+    QVERIFY(QFile::copy(resourceFile("project/lib/sub/CMakeLists.txt"), subFile)); \
+    QVERIFY(QFile::setPermissions(appFile, QFile::ReadOwner | QFile::WriteOwner)); \
+    QVERIFY(QFile::setPermissions(subFile, QFile::ReadOwner | QFile::WriteOwner))
+
+class TransactionTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void moveBetweenFiles()
+    {
+        TEMP_PROJECT();
+
+        cmle::Transaction transaction;
+        transaction.moveSourceFile(subFile, QStringLiteral("lib"), appFile, QStringLiteral("app"),
+                                   QStringLiteral("Sub.cpp"));
+        transaction.addSourceFile(appFile, QStringLiteral("app"), QStringLiteral("Sub.h"));
+        QCOMPARE(transaction.fileNames().size(), 2);
+        QVERIFY(transaction.commit());
+        QVERIFY(transaction.fileNames().isEmpty());
+
+        cmle::CMakeListsFile app{fileData(appFile)};
+        QCOMPARE(app.sourceFiles(QStringLiteral("app")),
+                 (QStringList{QStringLiteral("Main.cpp"), QStringLiteral("Sub.cpp"), QStringLiteral("Sub.h")}));
+
+        cmle::CMakeListsFile sub{fileData(subFile)};
+        QCOMPARE(sub.sourceFiles(QStringLiteral("lib")), QStringList{QStringLiteral("Sub.h")});
+
+        QCOMPARE(QDir{tempDir.filePath(QStringLiteral("app"))}.entryList(QDir::Files).size(), 1);
+        QCOMPARE(QDir{tempDir.filePath(QStringLiteral("lib/sub"))}.entryList(QDir::Files).size(), 1);
+    }
+
+    void allOrNothing()
+    {
+        TEMP_PROJECT();
+
+        const QByteArray appContent = fileData(appFile);
+        const QByteArray subContent = fileData(subFile);
+
+        cmle::Transaction transaction;
+        transaction.addSourceFile(appFile, QStringLiteral("app"), QStringLiteral("New.cpp"));
+        transaction.removeSourceFile(subFile, QStringLiteral("lib"), QStringLiteral("DoesNotExist.cpp"));
+
+        QTest::ignoreMessage(QtCriticalMsg, QRegularExpression(QStringLiteral("^Could not apply")));
+        QVERIFY(!transaction.commit());
+        QCOMPARE(transaction.fileNames().size(), 2);
+
+        QCOMPARE(fileData(appFile), appContent);
+        QCOMPARE(fileData(subFile), subContent);
+        QCOMPARE(QDir{tempDir.filePath(QStringLiteral("app"))}.entryList(QDir::Files).size(), 1);
+    }
+};
+
+#include "test_Transaction.moc"
+QTEST_MAIN(TransactionTest)
@@ -0,0 +1,181 @@
+// Copyright 2021-2023, Daniel Volk <mail@volkarts.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "training/Corpus.h"
+#include <cmle/CMakeListsFile.h>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMimeDatabase>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+constexpr int kRepetitions = 7;
+
+// reported to CTest as skipped, see SKIP_RETURN_CODE
+constexpr int kSkipped = 77;
+
+enum class Direction
+{
+    HigherIsBetter,
+    LowerIsBetter
+};
+
+struct Metric
+{
+    const char* name;
+    Direction direction;
+    double value;
+};
+
+// Fastest of several runs, which is far less noisy than the mean.
+qint64 fastestRun(const std::function<void()>& run)
+{
+    qint64 fastest = std::numeric_limits<qint64>::max();
+    for (int i = 0; i < kRepetitions; ++i)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        run();
+        fastest = std::min(fastest, timer.nsecsElapsed());
+    }
+    return std::max<qint64>(fastest, 1);
+}
+
+double megabytesPerSecond(qsizetype bytes, qint64 nsecs)
+{
+    return (static_cast<double>(bytes) / (1024.0 * 1024.0)) / (static_cast<double>(nsecs) / 1e9);
+}
+
+QList<Metric> measure()
+{
+    const QMimeType cppSrcMimeType = QMimeDatabase().mimeTypeForName(QStringLiteral("text/x-c++src"));
+
+    const QByteArray corpus = cmle::training::generateCorpus(600, 25);
+    // the size of a large CMakeLists.txt, as edited by IDE save hooks
+    const QByteArray listsFile = cmle::training::generateCorpus(20, 25);
+
+    const qint64 parseTime = fastestRun([&]() {
+        cmle::CMakeListsFile file{corpus};
+        Q_ASSERT(file.isLoaded());
+    });
+
+    cmle::CMakeListsFile editedFile{corpus};
+    editedFile.addSourceFile(QStringLiteral("target0"), QStringLiteral("src/New.cpp"), cppSrcMimeType);
+    QByteArray output;
+    const qint64 writeTime = fastestRun([&]() { output = editedFile.write(); });
+
+    const qint64 saveHookTime = fastestRun([&]() {
+        cmle::CMakeListsFile file{listsFile};
+        file.setSortSectionPolicy(cmle::SortSectionPolicy::Sort);
+        file.addSourceFile(QStringLiteral("target10"), QStringLiteral("src/module10/New.cpp"), cppSrcMimeType);
+        file.removeSourceFile(QStringLiteral("target10"), QStringLiteral("src/module10/SourceFile3.cpp"));
+        output = file.write();
+    });
+
+    return {
+        {"parse_mb_per_s", Direction::HigherIsBetter, megabytesPerSecond(corpus.size(), parseTime)},
+        {"write_mb_per_s", Direction::HigherIsBetter, megabytesPerSecond(output.size(), writeTime)},
+        {"save_hook_ms", Direction::LowerIsBetter, static_cast<double>(saveHookTime) / 1e6},
+    };
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Parse and write throughput of CMakeLists files"));
+    parser.addHelpOption();
+    parser.addOptions({
+        {QStringLiteral("baseline"), QStringLiteral("Baseline JSON file to compare against."),
+         QStringLiteral("file")},
+        {QStringLiteral("tolerance"), QStringLiteral("Allowed relative regression, defaults to 0.15."),
+         QStringLiteral("fraction"), QStringLiteral("0.15")},
+        {QStringLiteral("update-baseline"), QStringLiteral("Replace the baseline by the current results.")},
+    });
+    parser.process(app);
+
+    bool ok{};
+    const double tolerance = parser.value(QStringLiteral("tolerance")).toDouble(&ok);
+    if (!ok || tolerance < 0.0)
+    {
+        std::cerr << "Invalid tolerance" << std::endl;
+        return 2;
+    }
+
+    // checked before measuring, which takes a while
+    const QString baselineFileName = parser.value(QStringLiteral("baseline"));
+    const bool updateBaseline = parser.isSet(QStringLiteral("update-baseline"));
+    if (!baselineFileName.isEmpty() && !updateBaseline && !QFile::exists(baselineFileName))
+    {
+        std::cerr << "No baseline " << qPrintable(baselineFileName)
+                  << ", record one with --update-baseline (the perf_update_baseline target)" << std::endl;
+        return kSkipped;
+    }
+
+    const auto metrics = measure();
+
+    QJsonObject results;
+    for (const auto& metric : metrics)
+    {
+        results.insert(QLatin1String(metric.name), metric.value);
+    }
+    std::cout << QJsonDocument{results}.toJson().constData();
+
+    if (baselineFileName.isEmpty())
+        return 0;
+
+    QFile baselineFile{baselineFileName};
+    if (updateBaseline)
+    {
+        if (!baselineFile.open(QFile::WriteOnly | QFile::Truncate) ||
+                baselineFile.write(QJsonDocument{results}.toJson()) < 0)
+        {
+            std::cerr << "Could not write baseline " << qPrintable(baselineFileName) << std::endl;
+            return 2;
+        }
+        std::cout << "Recorded baseline " << qPrintable(baselineFileName) << std::endl;
+        return 0;
+    }
+
+    if (!baselineFile.open(QFile::ReadOnly))
+    {
+        std::cerr << "Could not read baseline " << qPrintable(baselineFileName) << std::endl;
+        return 2;
+    }
+    const QJsonObject baseline = QJsonDocument::fromJson(baselineFile.readAll()).object();
+
+    int regressions = 0;
+    for (const auto& metric : metrics)
+    {
+        const auto baselineValue = baseline.value(QLatin1String(metric.name));
+        if (!baselineValue.isDouble())
+        {
+            std::cout << metric.name << ": no baseline" << std::endl;
+            continue;
+        }
+
+        const double expected = baselineValue.toDouble();
+        const bool regressed = metric.direction == Direction::HigherIsBetter
+                ? metric.value < expected * (1.0 - tolerance)
+                : metric.value > expected * (1.0 + tolerance);
+
+        std::cout << metric.name << ": " << metric.value << " (baseline " << expected << ")"
+                  << (regressed ? " REGRESSION" : "") << std::endl;
+
+        if (regressed)
+            ++regressions;
+    }
+
+    return regressions == 0 ? 0 : 1;
+}